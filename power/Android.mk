@@ -14,7 +14,9 @@ include $(CLEAR_VARS)
 LOCAL_MODULE_RELATIVE_PATH := hw
 LOCAL_PROPRIETARY_MODULE := true
 LOCAL_SHARED_LIBRARIES := liblog libcutils libdl
-LOCAL_SRC_FILES := power.c metadata-parser.c utils.c list.c hint-data.c
+LOCAL_SRC_FILES := power.c metadata-parser.c utils.c hint-data.c hint-stats.c \
+    boost-config.c platform.c sysfs-perflock.c \
+    timer-wheel.c resource-resolver.c video-hint.c
 
 ifneq ($(BOARD_POWER_CUSTOM_BOARD_LIB),)
   LOCAL_WHOLE_STATIC_LIBRARIES += $(BOARD_POWER_CUSTOM_BOARD_LIB)
@@ -83,6 +85,15 @@ LOCAL_CFLAGS += -DSET_INTERACTIVE_EXT
 LOCAL_SRC_FILES += ../../../../$(TARGET_POWERHAL_SET_INTERACTIVE_EXT)
 endif
 
+ifeq ($(TARGET_POWERHAL_ASYNC_HINTS),true)
+LOCAL_CFLAGS += -DASYNC_HINTS
+LOCAL_SRC_FILES += hint-executor.c
+endif
+
+ifeq ($(TARGET_POWERHAL_SYSFS_READBACK),true)
+LOCAL_CFLAGS += -DSYSFS_WRITE_READBACK
+endif
+
 ifneq ($(TARGET_TAP_TO_WAKE_NODE),)
   LOCAL_CFLAGS += -DTAP_TO_WAKE_NODE=\"$(TARGET_TAP_TO_WAKE_NODE)\"
 endif
@@ -99,6 +110,26 @@ else
 LOCAL_MODULE := power.$(TARGET_BOARD_PLATFORM)
 endif
 LOCAL_MODULE_TAGS := optional
+
+# Everything but the SoC file, for the benchmark below.
+power_hal_src_files := $(filter-out power-8%.c,$(LOCAL_SRC_FILES))
+power_hal_cflags := $(LOCAL_CFLAGS)
+power_hal_static_libraries := $(LOCAL_STATIC_LIBRARIES)
+
 include $(BUILD_SHARED_LIBRARY)
 
+# Hint dispatch micro-benchmark, see hint-bench.c. Runs the generic
+# handlers against a fake sysfs tree and a stub perflock backend.
+ifeq ($(TARGET_POWERHAL_BENCHMARK),true)
+include $(CLEAR_VARS)
+
+LOCAL_SHARED_LIBRARIES := liblog libcutils libdl
+LOCAL_STATIC_LIBRARIES := $(power_hal_static_libraries)
+LOCAL_SRC_FILES := hint-bench.c $(power_hal_src_files)
+LOCAL_CFLAGS := $(power_hal_cflags)
+LOCAL_MODULE := power_hint_bench
+LOCAL_MODULE_TAGS := optional
+include $(BUILD_EXECUTABLE)
+endif
+
 endif # TARGET_POWERHAL_VARIANT == qcom || WITH_QC_PERF
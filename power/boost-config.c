@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2017 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Boost resource lists loaded from a config file.
+ *
+ * Each line of the file names a SoC id (or '*' for any SoC), a list and
+ * the perflock resource values to use for it, in any base strtol accepts:
+ *
+ *   # soc  list         values...
+ *   *      launch       0x40C00000 0x1 0x40800000 0xFFF
+ *   294    interaction  0x40800000 0x3E8
+ *
+ * Lines for other SoCs are ignored. A line naming this SoC always wins
+ * over a '*' line for the same list, wherever either appears in the file;
+ * between lines of the same kind, the later one replaces the earlier.
+ * Lists that are not configured keep the defaults compiled into the SoC
+ * file. The file is parsed once from power_init(), so the hint path only
+ * does an array lookup.
+ */
+
+#define LOG_NIDEBUG 0
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOG_TAG "QCOM PowerHAL"
+#include <utils/Log.h>
+
+#include "boost-config.h"
+#include "utils.h"
+
+#ifndef BOOST_CONFIG_PATH
+#define BOOST_CONFIG_PATH "/vendor/etc/power_boost.conf"
+#endif
+
+#define BOOST_LIST_MAX 32
+
+static const char *boost_list_names[BOOST_LIST_COUNT] = {
+    [BOOST_LAUNCH] = "launch",
+    [BOOST_INTERACTION] = "interaction",
+    [BOOST_INTERACTION_FLING] = "interaction_fling",
+    [BOOST_CPU_BOOST] = "cpu_boost",
+    [BOOST_PROFILE_POWER_SAVE] = "profile_power_save",
+    [BOOST_PROFILE_HIGH_PERFORMANCE] = "profile_high_performance",
+    [BOOST_PROFILE_BIAS_POWER] = "profile_bias_power",
+    [BOOST_PROFILE_BIAS_PERFORMANCE] = "profile_bias_performance",
+};
+
+struct boost_resources {
+    int count; /* 0 means use the built-in list. */
+    int soc_specific;
+    int values[BOOST_LIST_MAX];
+};
+
+static struct boost_resources boost_lists[BOOST_LIST_COUNT];
+
+static int parse_boost_line(char *line, int soc_id, int lineno)
+{
+    struct boost_resources resources = { 0 };
+    char *saveptr;
+    char *token;
+    char *end;
+    long value;
+    int list;
+
+    token = strtok_r(line, " \t\r\n", &saveptr);
+    if (!token || token[0] == '#')
+        return 0;
+
+    if (strcmp(token, "*")) {
+        value = strtol(token, &end, 0);
+        if (*end) {
+            ALOGE("%s:%d: invalid SoC id %s", BOOST_CONFIG_PATH, lineno, token);
+            return -1;
+        }
+        if (value != soc_id)
+            return 0;
+        resources.soc_specific = 1;
+    }
+
+    token = strtok_r(NULL, " \t\r\n", &saveptr);
+    for (list = 0; token && list < BOOST_LIST_COUNT; list++) {
+        if (!strcmp(token, boost_list_names[list]))
+            break;
+    }
+
+    if (!token || list == BOOST_LIST_COUNT) {
+        ALOGE("%s:%d: unknown boost list %s", BOOST_CONFIG_PATH, lineno,
+                token ? token : "");
+        return -1;
+    }
+
+    while ((token = strtok_r(NULL, " \t\r\n", &saveptr))) {
+        if (token[0] == '#')
+            break;
+
+        if (resources.count == BOOST_LIST_MAX) {
+            ALOGE("%s:%d: more than %d values", BOOST_CONFIG_PATH, lineno,
+                    BOOST_LIST_MAX);
+            return -1;
+        }
+
+        errno = 0;
+        value = strtoul(token, &end, 0);
+        if (*end || errno) {
+            ALOGE("%s:%d: invalid value %s", BOOST_CONFIG_PATH, lineno, token);
+            return -1;
+        }
+
+        resources.values[resources.count++] = (int)value;
+    }
+
+    if (!resources.count) {
+        ALOGE("%s:%d: empty boost list", BOOST_CONFIG_PATH, lineno);
+        return -1;
+    }
+
+    /* A wildcard never replaces a list configured for this SoC. */
+    if (boost_lists[list].soc_specific && !resources.soc_specific)
+        return 0;
+
+    boost_lists[list] = resources;
+
+    return 0;
+}
+
+void load_boost_config(void)
+{
+    char line[512];
+    int lineno = 0;
+    int soc_id;
+    FILE *file;
+
+    file = fopen(BOOST_CONFIG_PATH, "re");
+    if (!file)
+        return;
+
+    soc_id = get_soc_id();
+
+    while (fgets(line, sizeof(line), file)) {
+        lineno++;
+        /* A bad line is skipped, the rest of the file still applies. */
+        parse_boost_line(line, soc_id, lineno);
+    }
+
+    fclose(file);
+
+    ALOGI("Loaded boost config for SoC %d", soc_id);
+}
+
+/*
+ * The SoC files keep their defaults in a const table indexed by list, so
+ * picking the resources for a hint is a lookup with no setup work.
+ */
+void configured_interaction(enum boost_list list, int duration,
+        const struct resource_list builtin[BOOST_LIST_COUNT])
+{
+    const struct boost_resources *resources = &boost_lists[list];
+
+    if (resources->count)
+        interaction(duration, resources->count, resources->values);
+    else
+        interaction(duration, builtin[list].count, builtin[list].values);
+}
+
+void configured_hint_action(enum boost_list list, int hint_id,
+        const struct resource_list builtin[BOOST_LIST_COUNT])
+{
+    const struct boost_resources *resources = &boost_lists[list];
+
+    if (resources->count)
+        perform_hint_action(hint_id, resources->values, resources->count);
+    else
+        perform_hint_action(hint_id, builtin[list].values,
+                builtin[list].count);
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2017 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _QCOM_BOOST_CONFIG_H
+#define _QCOM_BOOST_CONFIG_H
+
+enum boost_list {
+    BOOST_LAUNCH,
+    BOOST_INTERACTION,
+    BOOST_INTERACTION_FLING,
+    BOOST_CPU_BOOST,
+    BOOST_PROFILE_POWER_SAVE,
+    BOOST_PROFILE_HIGH_PERFORMANCE,
+    BOOST_PROFILE_BIAS_POWER,
+    BOOST_PROFILE_BIAS_PERFORMANCE,
+    BOOST_LIST_COUNT,
+};
+
+/* A resource list compiled into a SoC file. */
+struct resource_list {
+    const int *values;
+    int count;
+};
+
+#define RESOURCE_LIST(array) { (array), sizeof(array) / sizeof((array)[0]) }
+
+void load_boost_config(void);
+void configured_interaction(enum boost_list list, int duration,
+        const struct resource_list builtin[BOOST_LIST_COUNT]);
+void configured_hint_action(enum boost_list list, int hint_id,
+        const struct resource_list builtin[BOOST_LIST_COUNT]);
+
+#endif
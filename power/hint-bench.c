@@ -0,0 +1,455 @@
+/*
+ * Copyright (C) 2017 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Micro-benchmark for the hint dispatch paths.
+ *
+ * Links the HAL sources into an executable and drives power_hint(),
+ * set_interactive(), perform_hint_action()/undo_hint_action() and
+ * parse_video_encode_metadata() against a fake sysfs tree and a stub
+ * perflock backend, first from one thread and then from several at once.
+ * Every call is timed on its own; p50/p99/p999 are exact over all calls,
+ * and heap allocations are counted by interposing malloc and friends.
+ *
+ *   power_hint_bench [-n calls] [-t threads] [sysfs root]
+ */
+
+#define LOG_NIDEBUG 0
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define LOG_TAG "QCOM PowerHAL"
+#include <utils/Log.h>
+#include <hardware/hardware.h>
+#include <hardware/power.h>
+
+#include "utils.h"
+#include "metadata-defs.h"
+#include "hint-data.h"
+#include "performance.h"
+#include "power-common.h"
+
+#define DEFAULT_CALLS 10000
+#define DEFAULT_THREADS 4
+#define DEFAULT_SYSFS_ROOT "/data/local/tmp/power-bench"
+
+extern struct power_module HAL_MODULE_INFO_SYM;
+
+/*
+ * Allocation counting. dlsym() may itself calloc() on some libcs, so
+ * those early requests are served from a small static arena.
+ */
+static void *(*real_malloc)(size_t size);
+static void *(*real_calloc)(size_t count, size_t size);
+static void *(*real_realloc)(void *ptr, size_t size);
+static void (*real_free)(void *ptr);
+
+static char bootstrap_arena[4096] __attribute__((aligned(16)));
+static size_t bootstrap_used;
+static int resolving_allocator;
+
+static atomic_int counting_allocations;
+static atomic_ulong allocations;
+
+static void resolve_allocator(void)
+{
+    if (real_free)
+        return;
+
+    resolving_allocator = 1;
+    real_malloc = dlsym(RTLD_NEXT, "malloc");
+    real_calloc = dlsym(RTLD_NEXT, "calloc");
+    real_realloc = dlsym(RTLD_NEXT, "realloc");
+    real_free = dlsym(RTLD_NEXT, "free");
+    resolving_allocator = 0;
+}
+
+static void count_allocation(void)
+{
+    if (atomic_load_explicit(&counting_allocations, memory_order_relaxed))
+        atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+}
+
+static int is_bootstrap(const void *ptr)
+{
+    return (const char *)ptr >= bootstrap_arena &&
+            (const char *)ptr < bootstrap_arena + sizeof(bootstrap_arena);
+}
+
+void *malloc(size_t size)
+{
+    resolve_allocator();
+    count_allocation();
+
+    return real_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    if (resolving_allocator) {
+        size_t len = (count * size + 15) & ~(size_t)15;
+        void *ptr;
+
+        if (bootstrap_used + len > sizeof(bootstrap_arena))
+            return NULL;
+
+        ptr = bootstrap_arena + bootstrap_used;
+        bootstrap_used += len;
+
+        return ptr;
+    }
+
+    resolve_allocator();
+    count_allocation();
+
+    return real_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    resolve_allocator();
+    count_allocation();
+
+    if (is_bootstrap(ptr)) {
+        void *copy = real_malloc(size);
+
+        if (copy)
+            memcpy(copy, ptr, size);
+        return copy;
+    }
+
+    return real_realloc(ptr, size);
+}
+
+void free(void *ptr)
+{
+    if (!ptr || is_bootstrap(ptr))
+        return;
+
+    resolve_allocator();
+    real_free(ptr);
+}
+
+/* Perflock stub: hands out handles and does nothing else. */
+static atomic_int next_handle = 2;
+
+static int stub_perf_lock_acq(unsigned long handle, int duration __unused,
+        int list[] __unused, int num_args __unused)
+{
+    return handle ? (int)handle : atomic_fetch_add(&next_handle, 1);
+}
+
+static int stub_perf_lock_rel(unsigned long handle __unused)
+{
+    return 0;
+}
+
+static const struct perflock_backend stub_perflock_backend = {
+    .acq = stub_perf_lock_acq,
+    .rel = stub_perf_lock_rel,
+};
+
+/* A 4 CPU, single cluster device running the interactive governor. */
+static const struct {
+    const char *path;
+    const char *value;
+} fake_sysfs_nodes[] = {
+    { "/sys/devices/soc0/soc_id", "206" },
+    { "/sys/devices/system/cpu/possible", "0-3" },
+    { "/sys/devices/system/cpu/cpu0/cpufreq/related_cpus", "0 1 2 3" },
+    { "/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_min_freq", "200000" },
+    { "/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_max_freq", "1200000" },
+    { "/sys/devices/system/cpu/cpu0/cpufreq/scaling_available_frequencies",
+            "200000 400000 800000 1200000" },
+    { "/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor", "interactive" },
+    { "/sys/devices/system/cpu/cpu0/cpufreq/scaling_min_freq", "200000" },
+    { "/sys/devices/system/cpu/cpu0/cpufreq/scaling_max_freq", "1200000" },
+    { "/sys/devices/system/cpu/cpufreq/interactive/timer_rate", "20000" },
+    { "/sys/devices/system/cpu/cpufreq/interactive/hispeed_freq", "800000" },
+    { "/sys/devices/system/cpu/cpufreq/interactive/go_hispeed_load", "90" },
+    { "/sys/devices/system/cpu/cpufreq/interactive/io_is_busy", "1" },
+};
+
+static int make_parent_dirs(char *path)
+{
+    char *slash;
+
+    for (slash = strchr(path + 1, '/'); slash; slash = strchr(slash + 1, '/')) {
+        *slash = '\0';
+        if (mkdir(path, 0755) && errno != EEXIST) {
+            *slash = '/';
+            return -1;
+        }
+        *slash = '/';
+    }
+
+    return 0;
+}
+
+static int create_fake_sysfs(const char *root)
+{
+    char path[PATH_MAX];
+    size_t i;
+    int fd;
+
+    for (i = 0; i < ARRAY_SIZE(fake_sysfs_nodes); i++) {
+        snprintf(path, sizeof(path), "%s%s", root, fake_sysfs_nodes[i].path);
+
+        if (make_parent_dirs(path) ||
+                (fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                        0644)) < 0) {
+            fprintf(stderr, "Unable to create %s: %s\n", path,
+                    strerror(errno));
+            return -1;
+        }
+
+        if (write(fd, fake_sysfs_nodes[i].value,
+                strlen(fake_sysfs_nodes[i].value)) < 0)
+            fprintf(stderr, "Unable to write %s: %s\n", path,
+                    strerror(errno));
+        close(fd);
+    }
+
+    return 0;
+}
+
+/* The calls being measured. Each gets the thread and call index. */
+static void bench_interaction(int thread __unused, int i)
+{
+    int duration = 100 + (i & 3) * 100;
+
+    HAL_MODULE_INFO_SYM.powerHint(&HAL_MODULE_INFO_SYM,
+            POWER_HINT_INTERACTION, &duration);
+}
+
+static void bench_launch(int thread __unused, int i __unused)
+{
+    int launch = 1;
+
+    HAL_MODULE_INFO_SYM.powerHint(&HAL_MODULE_INFO_SYM,
+            POWER_HINT_LAUNCH, &launch);
+}
+
+static void bench_set_interactive(int thread __unused, int i)
+{
+    HAL_MODULE_INFO_SYM.setInteractive(&HAL_MODULE_INFO_SYM, i & 1);
+}
+
+static int hint_action_resources[] = {
+    CPUS_ONLINE_MIN_2, CPU0_MIN_FREQ_TURBO_MAX,
+};
+
+/* Alternates acquire and release; each thread uses its own hint id. */
+static void bench_hint_action(int thread, int i)
+{
+    int hint_id = 0x2000 + thread * 0x100;
+
+    if (i & 1)
+        undo_hint_action(hint_id);
+    else
+        perform_hint_action(hint_id, hint_action_resources,
+                ARRAY_SIZE(hint_action_resources));
+}
+
+static void bench_parse_video_encode(int thread __unused, int i)
+{
+    struct video_encode_metadata_t metadata;
+
+    parse_video_encode_metadata(i & 1 ? "hint_id=2560;state=0" :
+            "hint_id=2560;state=1;width=1920;height=1080;fps=30",
+            &metadata);
+}
+
+static const struct {
+    const char *name;
+    void (*call)(int thread, int i);
+} benchmarks[] = {
+    { "power_hint(INTERACTION)", bench_interaction },
+    { "power_hint(LAUNCH)", bench_launch },
+    { "set_interactive", bench_set_interactive },
+    { "perform/undo_hint_action", bench_hint_action },
+    { "parse_video_encode_metadata", bench_parse_video_encode },
+};
+
+struct bench_thread {
+    pthread_t thread;
+    int index;
+    void (*call)(int thread, int i);
+    long long *samples;
+};
+
+static int calls_per_thread = DEFAULT_CALLS;
+static pthread_barrier_t start_barrier;
+
+static long long now_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+static void *bench_thread_main(void *arg)
+{
+    struct bench_thread *bench = arg;
+    long long start;
+    int i;
+
+    pthread_barrier_wait(&start_barrier);
+
+    for (i = 0; i < calls_per_thread; i++) {
+        start = now_ns();
+        bench->call(bench->index, i);
+        bench->samples[i] = now_ns() - start;
+    }
+
+    return NULL;
+}
+
+static int compare_samples(const void *a, const void *b)
+{
+    long long x = *(const long long *)a;
+    long long y = *(const long long *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static long long percentile(const long long *sorted, size_t count,
+        unsigned int permille)
+{
+    size_t rank = (count * permille + 999) / 1000;
+
+    return sorted[rank ? rank - 1 : 0];
+}
+
+static int run_benchmark(const char *name, void (*call)(int thread, int i),
+        int num_threads)
+{
+    size_t total = (size_t)num_threads * calls_per_thread;
+    struct bench_thread *threads;
+    long long *samples;
+    unsigned long allocs;
+    int i;
+
+    threads = calloc(num_threads, sizeof(*threads));
+    samples = calloc(total, sizeof(*samples));
+    if (!threads || !samples) {
+        fprintf(stderr, "Out of memory\n");
+        free(threads);
+        free(samples);
+        return -1;
+    }
+
+    /* The main thread releases the workers once they are all created. */
+    pthread_barrier_init(&start_barrier, NULL, num_threads + 1);
+
+    for (i = 0; i < num_threads; i++) {
+        threads[i].index = i;
+        threads[i].call = call;
+        threads[i].samples = samples + (size_t)i * calls_per_thread;
+        pthread_create(&threads[i].thread, NULL, bench_thread_main,
+                &threads[i]);
+    }
+
+    atomic_store(&allocations, 0);
+    atomic_store(&counting_allocations, 1);
+    pthread_barrier_wait(&start_barrier);
+
+    for (i = 0; i < num_threads; i++)
+        pthread_join(threads[i].thread, NULL);
+
+    atomic_store(&counting_allocations, 0);
+    allocs = atomic_load(&allocations);
+
+    pthread_barrier_destroy(&start_barrier);
+
+    qsort(samples, total, sizeof(*samples), compare_samples);
+
+    printf("%-28s threads=%-2d calls=%-7zu p50=%lldns p99=%lldns "
+            "p999=%lldns allocs/call=%.3f\n", name, num_threads, total,
+            percentile(samples, total, 500), percentile(samples, total, 990),
+            percentile(samples, total, 999), (double)allocs / total);
+
+    free(threads);
+    free(samples);
+
+    return 0;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "usage: %s [-n calls] [-t threads] [sysfs root]\n",
+            argv0);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *root = DEFAULT_SYSFS_ROOT;
+    int num_threads = DEFAULT_THREADS;
+    size_t i;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:t:")) != -1) {
+        switch (opt) {
+            case 'n':
+                calls_per_thread = atoi(optarg);
+                break;
+            case 't':
+                num_threads = atoi(optarg);
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (optind < argc)
+        root = argv[optind];
+
+    if (calls_per_thread < 1 || num_threads < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (create_fake_sysfs(root))
+        return 1;
+
+    set_sysfs_root(root);
+    set_perflock_backend(&stub_perflock_backend);
+    HAL_MODULE_INFO_SYM.init(&HAL_MODULE_INFO_SYM);
+
+    for (i = 0; i < ARRAY_SIZE(benchmarks); i++) {
+        if (run_benchmark(benchmarks[i].name, benchmarks[i].call, 1))
+            return 1;
+        if (num_threads > 1 &&
+                run_benchmark(benchmarks[i].name, benchmarks[i].call,
+                        num_threads))
+            return 1;
+    }
+
+    return 0;
+}
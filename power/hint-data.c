@@ -27,21 +27,114 @@
  * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <stddef.h>
+
 #include "hint-data.h"
 
-int hint_compare(struct hint_data *first_hint,
-        struct hint_data *other_hint) {
-    if (first_hint == other_hint) {
-        return 0;
-    } else if ((first_hint && other_hint) &&
-            (first_hint->hint_id == other_hint->hint_id)) {
-        return 0;
+/* Hint ids are multiples of 0x100, so mix the bits before masking. */
+static unsigned int hint_hash(unsigned long hint_id)
+{
+    return ((unsigned int)hint_id * 2654435761u) >> 16;
+}
+
+static struct hint_data *find_slot(struct hint_table *table,
+        unsigned long hint_id)
+{
+    unsigned int i = hint_hash(hint_id) & (HINT_TABLE_SIZE - 1);
+    int probes;
+
+    for (probes = 0; probes < HINT_TABLE_SIZE; probes++) {
+        struct hint_data *entry = &table->entries[i];
+
+        if (!entry->in_use || entry->hint_id == hint_id)
+            return entry;
+
+        i = (i + 1) & (HINT_TABLE_SIZE - 1);
+    }
+
+    return NULL;
+}
+
+/*
+ * Records the perflock held for hint_id. If the hint was already active,
+ * its entry is updated and the superseded handle is returned in
+ * *old_handle (0 otherwise) for the caller to release.
+ *
+ * Returns -1 if the table is full.
+ */
+int hint_table_insert(struct hint_table *table, unsigned long hint_id,
+        unsigned long perflock_handle, unsigned long *old_handle)
+{
+    struct hint_data *entry = find_slot(table, hint_id);
+
+    *old_handle = 0;
+
+    if (entry == NULL)
+        return -1;
+
+    if (entry->in_use) {
+        *old_handle = entry->perflock_handle;
     } else {
-        return 1;
+        if (table->count == HINT_TABLE_SIZE - 1)
+            return -1;
+
+        entry->hint_id = hint_id;
+        entry->in_use = 1;
+        table->count++;
     }
+
+    entry->perflock_handle = perflock_handle;
+
+    return 0;
 }
 
-void hint_dump(__attribute__((unused)) struct hint_data *hint)
+/*
+ * Finds and removes hint_id in one lookup, returning its perflock handle.
+ * Later entries of the probe run are shifted back into the hole, so
+ * lookups never have to skip over deleted slots.
+ *
+ * Returns -1 if the hint isn't active.
+ */
+int hint_table_remove(struct hint_table *table, unsigned long hint_id,
+        unsigned long *perflock_handle)
 {
-    /*ALOGI("hint_id: %lu", hint->hint_id);*/
+    struct hint_data *entry = find_slot(table, hint_id);
+    unsigned int hole, i;
+
+    if (entry == NULL || !entry->in_use)
+        return -1;
+
+    *perflock_handle = entry->perflock_handle;
+
+    hole = entry - table->entries;
+    i = hole;
+
+    for (;;) {
+        unsigned int home;
+
+        i = (i + 1) & (HINT_TABLE_SIZE - 1);
+        if (!table->entries[i].in_use)
+            break;
+
+        /* Move the entry back only if the hole lies on its probe path. */
+        home = hint_hash(table->entries[i].hint_id) & (HINT_TABLE_SIZE - 1);
+        if (((i - home) & (HINT_TABLE_SIZE - 1)) >=
+                ((i - hole) & (HINT_TABLE_SIZE - 1))) {
+            table->entries[hole] = table->entries[i];
+            hole = i;
+        }
+    }
+
+    table->entries[hole].in_use = 0;
+    table->count--;
+
+    return 0;
+}
+
+/* Returns 1 if hint_id currently holds a perflock, 0 otherwise. */
+int hint_table_contains(struct hint_table *table, unsigned long hint_id)
+{
+    struct hint_data *entry = find_slot(table, hint_id);
+
+    return entry != NULL && entry->in_use;
 }
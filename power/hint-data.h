@@ -36,11 +36,26 @@
 #define DEFAULT_PROFILE_HINT_ID         (0x0F00)
 #define CAM_PREVIEW_HINT_ID             (0x1000)
 
+/* Fixed capacity of the active hint table. Must be a power of two. */
+#define HINT_TABLE_SIZE                 (64)
+
 struct hint_data {
     unsigned long hint_id; /* This is our key. */
     unsigned long perflock_handle;
+    int in_use;
+};
+
+/*
+ * Open-addressed table of active hints keyed by hint_id. Entries live in
+ * the table itself, so insert and remove never allocate.
+ */
+struct hint_table {
+    struct hint_data entries[HINT_TABLE_SIZE];
+    int count;
 };
 
-int hint_compare(struct hint_data *first_hint,
-        struct hint_data *other_hint);
-void hint_dump(struct hint_data *hint);
+int hint_table_insert(struct hint_table *table, unsigned long hint_id,
+        unsigned long perflock_handle, unsigned long *old_handle);
+int hint_table_remove(struct hint_table *table, unsigned long hint_id,
+        unsigned long *perflock_handle);
+int hint_table_contains(struct hint_table *table, unsigned long hint_id);
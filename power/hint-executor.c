@@ -0,0 +1,499 @@
+/*
+ * Copyright (C) 2017 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Asynchronous hint executor.
+ *
+ * power_hint() copies the hint into a small record and pushes it onto a
+ * bounded lock-free ring, then returns. A single executor thread drains
+ * the ring, merges redundant records and runs the rest through the normal
+ * synchronous handler, so perfd IPC and sysfs writes stay off the caller's
+ * binder thread. If the ring is full the caller waits for the executor to
+ * make room, so hints are always handled in the order they arrived.
+ *
+ * Hints whose payload can't be copied into a record (unknown hint types,
+ * video metadata longer than HINT_METADATA_MAX) still go through the ring,
+ * borrowing the caller's data; the caller then waits until the executor
+ * has run them, so they can't overtake hints queued before them.
+ */
+
+#define LOG_NIDEBUG 0
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#define LOG_TAG "QCOM PowerHAL"
+#include <utils/Log.h>
+
+#include "hint-executor.h"
+#include "hint-stats.h"
+#include "video-hint.h"
+
+#define HINT_QUEUE_SIZE 64 /* Must be a power of two. */
+#define HINT_METADATA_MAX 96
+
+/* What the SoC handlers boost for when an interaction carries no data. */
+#define INTERACTION_DEFAULT_MS 500
+
+#define HINT_RECORD_HAS_DATA (1 << 0)
+/* data.borrowed points at the caller's payload, which waits on done. */
+#define HINT_RECORD_BORROWED (1 << 1)
+
+struct hint_record {
+    struct power_module *module;
+    power_hint_t hint;
+    int flags;
+    atomic_int *done;
+    union {
+        int value;
+        char metadata[HINT_METADATA_MAX];
+        void *borrowed;
+    } data;
+};
+
+struct hint_cell {
+    atomic_size_t seq;
+    struct hint_record record;
+};
+
+static struct hint_cell hint_queue[HINT_QUEUE_SIZE];
+static atomic_size_t enqueue_pos;
+static size_t dequeue_pos;
+
+static hint_handler_t hint_handler;
+static atomic_int executor_running;
+static int wake_fd = -1;
+
+/* Producers waiting for the executor to free a cell. */
+static atomic_int queue_waiters;
+static pthread_mutex_t queue_space_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_space_cond = PTHREAD_COND_INITIALIZER;
+
+/* Callers waiting for a borrowed record to run, also on queue_space_lock. */
+static pthread_cond_t hint_done_cond = PTHREAD_COND_INITIALIZER;
+
+/*
+ * Multi-producer push, after Vyukov's bounded queue: each cell carries a
+ * sequence number telling producers and the consumer whose turn it is.
+ */
+static int hint_queue_push(const struct hint_record *record)
+{
+    size_t pos = atomic_load_explicit(&enqueue_pos, memory_order_relaxed);
+    struct hint_cell *cell;
+
+    for (;;) {
+        size_t seq;
+        intptr_t diff;
+
+        cell = &hint_queue[pos & (HINT_QUEUE_SIZE - 1)];
+        seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        diff = (intptr_t)seq - (intptr_t)pos;
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&enqueue_pos, &pos,
+                    pos + 1, memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            /* Full. */
+            return -1;
+        } else {
+            pos = atomic_load_explicit(&enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    cell->record = *record;
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+
+    return 0;
+}
+
+/* Single consumer: only the executor thread pops. */
+static int hint_queue_pop(struct hint_record *record)
+{
+    struct hint_cell *cell = &hint_queue[dequeue_pos & (HINT_QUEUE_SIZE - 1)];
+    size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+
+    if ((intptr_t)seq - (intptr_t)(dequeue_pos + 1) < 0)
+        return -1;
+
+    *record = cell->record;
+    atomic_store_explicit(&cell->seq, dequeue_pos + HINT_QUEUE_SIZE,
+            memory_order_release);
+    dequeue_pos++;
+
+    return 0;
+}
+
+static int get_video_hint_state(const struct hint_record *record,
+        int *hint_id, int *state)
+{
+    struct video_hint_params params;
+
+    if ((record->flags & (HINT_RECORD_HAS_DATA | HINT_RECORD_BORROWED)) !=
+            HINT_RECORD_HAS_DATA ||
+            parse_video_hint(record->hint, record->data.metadata, &params))
+        return -1;
+
+    *hint_id = params.hint_id;
+    *state = params.state;
+
+    return 0;
+}
+
+/*
+ * Returns the duration a boost record stands for when merging. Only an
+ * interaction without a duration gets the handlers' default; a short one
+ * stays short.
+ */
+static int record_duration(const struct hint_record *record)
+{
+    int value = (record->flags & HINT_RECORD_HAS_DATA) ?
+            record->data.value : 0;
+
+    if (record->hint == POWER_HINT_INTERACTION && value <= 0)
+        return INTERACTION_DEFAULT_MS;
+
+    return value;
+}
+
+/* Launch records only merge if both are starts or both are ends. */
+static int same_launch_state(const struct hint_record *a,
+        const struct hint_record *b)
+{
+    int a_value = (a->flags & HINT_RECORD_HAS_DATA) ? a->data.value : -1;
+    int b_value = (b->flags & HINT_RECORD_HAS_DATA) ? b->data.value : -1;
+
+    return a_value == b_value;
+}
+
+/* Wakes callers waiting for their borrowed record to run. */
+static void signal_hint_done(atomic_int *done)
+{
+    pthread_mutex_lock(&queue_space_lock);
+    if (done)
+        atomic_store(done, 1);
+    pthread_cond_broadcast(&hint_done_cond);
+    pthread_mutex_unlock(&queue_space_lock);
+}
+
+/* Wakes producers blocked on a full queue after the executor popped. */
+static void signal_queue_space(void)
+{
+    atomic_thread_fence(memory_order_seq_cst);
+
+    if (!atomic_load(&queue_waiters))
+        return;
+
+    pthread_mutex_lock(&queue_space_lock);
+    pthread_cond_broadcast(&queue_space_cond);
+    pthread_mutex_unlock(&queue_space_lock);
+}
+
+/*
+ * Pushes a record, waiting while the queue is full. Returns -1 only if
+ * the executor is gone, in which case the caller handles the hint itself.
+ */
+static int hint_queue_push_wait(const struct hint_record *record)
+{
+    int rc = 0;
+
+    if (hint_queue_push(record) == 0)
+        return 0;
+
+    atomic_fetch_add(&queue_waiters, 1);
+    pthread_mutex_lock(&queue_space_lock);
+
+    /* Retried under the lock, so a pop can't slip in before the wait. */
+    while (hint_queue_push(record)) {
+        if (!atomic_load(&executor_running)) {
+            rc = -1;
+            break;
+        }
+        pthread_cond_wait(&queue_space_cond, &queue_space_lock);
+    }
+
+    pthread_mutex_unlock(&queue_space_lock);
+    atomic_fetch_sub(&queue_waiters, 1);
+
+    return rc;
+}
+
+/*
+ * Merges redundant records in a drained batch. Dropped records get their
+ * hint set to 0. Nothing merges across a borrowed record.
+ *  - Repeated interaction and cpu boosts become one boost with the longest
+ *    duration; an interaction without a duration counts as 500ms.
+ *  - Repeated profile hints keep only the last one, and so do repeated
+ *    launch starts or launch ends. A start followed by an end keeps both.
+ *  - A video start followed by a stop of the same hint_id drops both: the
+ *    session count for the hint_id ends up where it started either way.
+ */
+static void coalesce_hints(struct hint_record *batch, int count)
+{
+    int i, j;
+
+    for (i = 0; i < count; i++) {
+        struct hint_record *first = &batch[i];
+        int hint_id, state;
+
+        if (first->flags & HINT_RECORD_BORROWED)
+            continue;
+
+        switch (first->hint) {
+            case POWER_HINT_INTERACTION:
+            case POWER_HINT_CPU_BOOST:
+                for (j = i + 1; j < count; j++) {
+                    int duration;
+
+                    if (batch[j].flags & HINT_RECORD_BORROWED)
+                        break;
+                    if (batch[j].hint != first->hint)
+                        continue;
+
+                    duration = record_duration(&batch[j]);
+                    if (duration < record_duration(first))
+                        duration = record_duration(first);
+
+                    first->flags |= HINT_RECORD_HAS_DATA;
+                    first->data.value = duration;
+                    hint_stats_inc(batch[j].hint, HINT_STAT_MERGED);
+                    batch[j].hint = 0;
+                }
+                break;
+            case POWER_HINT_LAUNCH:
+            case POWER_HINT_SET_PROFILE:
+                for (j = i + 1; j < count; j++) {
+                    if (batch[j].flags & HINT_RECORD_BORROWED)
+                        break;
+                    if (batch[j].hint != first->hint)
+                        continue;
+
+                    if (first->hint == POWER_HINT_SET_PROFILE ||
+                            same_launch_state(first, &batch[j])) {
+                        hint_stats_inc(first->hint, HINT_STAT_MERGED);
+                        first->hint = 0;
+                    }
+                    break;
+                }
+                break;
+            case POWER_HINT_VIDEO_ENCODE:
+            case POWER_HINT_VIDEO_DECODE:
+                if (get_video_hint_state(first, &hint_id, &state) || state != 1)
+                    break;
+
+                for (j = i + 1; j < count; j++) {
+                    int other_hint_id, other_state;
+
+                    if (batch[j].flags & HINT_RECORD_BORROWED)
+                        break;
+                    if (batch[j].hint != first->hint ||
+                            get_video_hint_state(&batch[j], &other_hint_id,
+                                    &other_state) ||
+                            other_hint_id != hint_id)
+                        continue;
+
+                    if (other_state == 0) {
+                        hint_stats_inc(first->hint, HINT_STAT_MERGED);
+                        hint_stats_inc(batch[j].hint, HINT_STAT_MERGED);
+                        first->hint = 0;
+                        batch[j].hint = 0;
+                    }
+                    break;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+static void run_hint(struct hint_record *record)
+{
+    void *data = NULL;
+
+    if (record->flags & HINT_RECORD_BORROWED) {
+        data = record->data.borrowed;
+    } else if (record->flags & HINT_RECORD_HAS_DATA) {
+        if (record->hint == POWER_HINT_VIDEO_ENCODE ||
+                record->hint == POWER_HINT_VIDEO_DECODE)
+            data = record->data.metadata;
+        else
+            data = &record->data.value;
+    }
+
+    hint_handler(record->module, record->hint, data);
+}
+
+static void *hint_executor(void *arg __unused)
+{
+    struct hint_record batch[HINT_QUEUE_SIZE];
+    uint64_t pending;
+    int count, i;
+
+    for (;;) {
+        if (read(wake_fd, &pending, sizeof(pending)) < 0 && errno != EINTR) {
+            ALOGE("Hint executor wakeup failed: %s", strerror(errno));
+            break;
+        }
+
+        for (;;) {
+            count = 0;
+            while (count < HINT_QUEUE_SIZE && hint_queue_pop(&batch[count]) == 0)
+                count++;
+
+            if (count == 0)
+                break;
+
+            signal_queue_space();
+            coalesce_hints(batch, count);
+
+            for (i = 0; i < count; i++) {
+                if (batch[i].hint)
+                    run_hint(&batch[i]);
+                if (batch[i].flags & HINT_RECORD_BORROWED)
+                    signal_hint_done(batch[i].done);
+            }
+        }
+    }
+
+    atomic_store(&executor_running, 0);
+
+    /* Let blocked producers fall back to handling hints themselves. */
+    pthread_mutex_lock(&queue_space_lock);
+    pthread_cond_broadcast(&queue_space_cond);
+    pthread_cond_broadcast(&hint_done_cond);
+    pthread_mutex_unlock(&queue_space_lock);
+
+    return NULL;
+}
+
+int start_hint_executor(hint_handler_t handler)
+{
+    pthread_attr_t attr;
+    pthread_t thread;
+    int expected = 0;
+    size_t i;
+
+    if (!atomic_compare_exchange_strong(&executor_running, &expected, 1))
+        return 0;
+
+    for (i = 0; i < HINT_QUEUE_SIZE; i++)
+        atomic_init(&hint_queue[i].seq, i);
+
+    hint_handler = handler;
+
+    wake_fd = eventfd(0, EFD_CLOEXEC);
+    if (wake_fd < 0) {
+        ALOGE("Unable to create hint executor eventfd: %s", strerror(errno));
+        atomic_store(&executor_running, 0);
+        return -1;
+    }
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+    if (pthread_create(&thread, &attr, hint_executor, NULL)) {
+        ALOGE("Unable to start hint executor.");
+        pthread_attr_destroy(&attr);
+        close(wake_fd);
+        wake_fd = -1;
+        atomic_store(&executor_running, 0);
+        return -1;
+    }
+
+    pthread_attr_destroy(&attr);
+
+    return 0;
+}
+
+/*
+ * Queues a borrowed record and waits for the executor to run it. Returns
+ * -1 if the executor stopped before getting to it.
+ */
+static int run_behind_queue(struct hint_record *record, void *data)
+{
+    atomic_int done = 0;
+    uint64_t one = 1;
+
+    record->flags = HINT_RECORD_BORROWED;
+    record->done = &done;
+    record->data.borrowed = data;
+
+    if (hint_queue_push_wait(record))
+        return -1;
+
+    if (write(wake_fd, &one, sizeof(one)) < 0)
+        ALOGW("Hint executor wakeup failed: %s", strerror(errno));
+
+    pthread_mutex_lock(&queue_space_lock);
+    while (!atomic_load(&done) && atomic_load(&executor_running))
+        pthread_cond_wait(&hint_done_cond, &queue_space_lock);
+    pthread_mutex_unlock(&queue_space_lock);
+
+    return atomic_load(&done) ? 0 : -1;
+}
+
+/*
+ * Queues a hint for the executor thread, waiting for room if the queue is
+ * full. Hints whose payload we don't know how to copy are run by the
+ * executor too, with the caller waiting for them. Returns -1 if the hint
+ * must be handled synchronously instead because the executor isn't running.
+ */
+int queue_power_hint(struct power_module *module, power_hint_t hint,
+        void *data)
+{
+    struct hint_record record;
+    uint64_t one = 1;
+
+    if (!atomic_load_explicit(&executor_running, memory_order_acquire))
+        return -1;
+
+    record.module = module;
+    record.hint = hint;
+    record.flags = data ? HINT_RECORD_HAS_DATA : 0;
+    record.done = NULL;
+
+    switch (hint) {
+        case POWER_HINT_INTERACTION:
+        case POWER_HINT_LAUNCH:
+        case POWER_HINT_CPU_BOOST:
+        case POWER_HINT_SET_PROFILE:
+            if (data)
+                record.data.value = *(int32_t *)data;
+            break;
+        case POWER_HINT_VIDEO_ENCODE:
+        case POWER_HINT_VIDEO_DECODE:
+            if (data && strlcpy(record.data.metadata, (char *)data,
+                    sizeof(record.data.metadata)) >= sizeof(record.data.metadata))
+                return run_behind_queue(&record, data);
+            break;
+        default:
+            return run_behind_queue(&record, data);
+    }
+
+    if (hint_queue_push_wait(&record))
+        return -1;
+
+    if (write(wake_fd, &one, sizeof(one)) < 0)
+        ALOGW("Hint executor wakeup failed: %s", strerror(errno));
+
+    return 0;
+}
@@ -0,0 +1,29 @@
+/*
+ * Copyright (C) 2017 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _QCOM_HINT_EXECUTOR_H
+#define _QCOM_HINT_EXECUTOR_H
+
+#include <hardware/power.h>
+
+typedef void (*hint_handler_t)(struct power_module *module,
+        power_hint_t hint, void *data);
+
+int start_hint_executor(hint_handler_t handler);
+int queue_power_hint(struct power_module *module, power_hint_t hint,
+        void *data);
+
+#endif
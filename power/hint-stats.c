@@ -0,0 +1,265 @@
+/*
+ * Copyright (C) 2017 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Hint counters and latency histograms.
+ *
+ * Everything is a relaxed atomic increment, so recording costs a couple of
+ * uncontended adds per hint and never takes a lock. Counts from concurrent
+ * hints may be observed slightly out of step with each other in a dump,
+ * which is fine for statistics.
+ */
+
+#define LOG_NIDEBUG 0
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <time.h>
+
+#define LOG_TAG "QCOM PowerHAL"
+#include <utils/Log.h>
+
+#include "hint-stats.h"
+
+#define ARRAY_SIZE(arr) (sizeof(arr) / sizeof(arr[0]))
+
+/* Bucket i counts latencies below 2^i us; the last one takes the rest. */
+#define LATENCY_BUCKETS 16
+
+struct latency_histogram {
+    atomic_uint buckets[LATENCY_BUCKETS];
+};
+
+struct hint_stats {
+    power_hint_t hint;
+    const char *name;
+    atomic_uint counts[HINT_STAT_COUNT];
+    struct latency_histogram latency;
+};
+
+static struct hint_stats hint_stats_table[] = {
+    { 0, "other" },
+    { POWER_HINT_VSYNC, "vsync" },
+    { POWER_HINT_INTERACTION, "interaction" },
+    { POWER_HINT_VIDEO_ENCODE, "video_encode" },
+    { POWER_HINT_VIDEO_DECODE, "video_decode" },
+    { POWER_HINT_LOW_POWER, "low_power" },
+    { POWER_HINT_SUSTAINED_PERFORMANCE, "sustained_perf" },
+    { POWER_HINT_VR_MODE, "vr_mode" },
+    { POWER_HINT_LAUNCH, "launch" },
+    { POWER_HINT_DISABLE_TOUCH, "disable_touch" },
+    { POWER_HINT_CPU_BOOST, "cpu_boost" },
+    { POWER_HINT_SET_PROFILE, "set_profile" },
+};
+
+static const char *hint_stat_names[HINT_STAT_COUNT] = {
+    [HINT_STAT_RECEIVED] = "received",
+    [HINT_STAT_DEBOUNCED] = "debounced",
+    [HINT_STAT_MERGED] = "merged",
+    [HINT_STAT_HANDLED] = "handled",
+    [HINT_STAT_FAILED] = "failed",
+};
+
+enum hint_outcome {
+    HINT_OUTCOME_NONE,
+    HINT_OUTCOME_ACTED,
+    HINT_OUTCOME_FAILED,
+};
+
+/* What the hint being processed on this thread has done so far. */
+static __thread enum hint_outcome hint_outcome;
+
+static atomic_uint perflock_acquires;
+static atomic_uint perflock_failures;
+static struct latency_histogram perflock_latency;
+static atomic_uint sysfs_write_failures;
+
+static struct hint_stats *get_hint_stats(power_hint_t hint)
+{
+    size_t i;
+
+    for (i = 1; i < ARRAY_SIZE(hint_stats_table); i++) {
+        if (hint_stats_table[i].hint == hint)
+            return &hint_stats_table[i];
+    }
+
+    return &hint_stats_table[0];
+}
+
+static void record_latency(struct latency_histogram *histogram,
+        long long start_us)
+{
+    long long elapsed = hint_stats_now_us() - start_us;
+    int bucket = 0;
+
+    while (bucket < LATENCY_BUCKETS - 1 && elapsed >= (1LL << bucket))
+        bucket++;
+
+    atomic_fetch_add_explicit(&histogram->buckets[bucket], 1,
+            memory_order_relaxed);
+}
+
+/*
+ * Returns the bucket holding the given percentile of total samples.
+ */
+static int latency_percentile(struct latency_histogram *histogram,
+        unsigned int permille, unsigned int total)
+{
+    unsigned long long rank = ((unsigned long long)total * permille + 999) / 1000;
+    unsigned long long seen = 0;
+    int i;
+
+    for (i = 0; i < LATENCY_BUCKETS - 1; i++) {
+        seen += atomic_load_explicit(&histogram->buckets[i],
+                memory_order_relaxed);
+        if (seen >= rank)
+            break;
+    }
+
+    return i;
+}
+
+/*
+ * Formats p50/p99/p999 as the upper bound of the power-of-two bucket each
+ * falls in.
+ */
+static void format_latency(char *buf, size_t size,
+        struct latency_histogram *histogram)
+{
+    static const unsigned int permille[] = { 500, 990, 999 };
+    static const char *names[] = { "p50", "p99", "p999" };
+    unsigned int total = 0;
+    size_t i;
+    int len = 0;
+
+    for (i = 0; i < LATENCY_BUCKETS; i++)
+        total += atomic_load_explicit(&histogram->buckets[i],
+                memory_order_relaxed);
+
+    buf[0] = '\0';
+
+    for (i = 0; total && i < ARRAY_SIZE(permille) && len < (int)size; i++) {
+        int bucket = latency_percentile(histogram, permille[i], total);
+
+        if (bucket < LATENCY_BUCKETS - 1)
+            len += snprintf(buf + len, size - len, " %s<%lldus", names[i],
+                    1LL << bucket);
+        else
+            len += snprintf(buf + len, size - len, " %s>=%lldus", names[i],
+                    1LL << (LATENCY_BUCKETS - 2));
+    }
+}
+
+long long hint_stats_now_us(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec * 1000000LL + now.tv_nsec / 1000;
+}
+
+void hint_stats_inc(power_hint_t hint, enum hint_stat stat)
+{
+    atomic_fetch_add_explicit(&get_hint_stats(hint)->counts[stat], 1,
+            memory_order_relaxed);
+}
+
+/*
+ * hint_stats_begin() and hint_stats_end() bracket the processing of one
+ * hint. In between, every perflock taken or released on its behalf is
+ * reported through hint_stats_action(). A hint only counts as handled if
+ * it acted and nothing failed; one that was debounced or turned out to be
+ * a no-op counts as neither handled nor failed.
+ */
+void hint_stats_begin(void)
+{
+    hint_outcome = HINT_OUTCOME_NONE;
+}
+
+void hint_stats_action(int failed)
+{
+    if (failed)
+        hint_outcome = HINT_OUTCOME_FAILED;
+    else if (hint_outcome == HINT_OUTCOME_NONE)
+        hint_outcome = HINT_OUTCOME_ACTED;
+}
+
+/* Also records how long the hint took, measured from start_us. */
+void hint_stats_end(power_hint_t hint, long long start_us)
+{
+    struct hint_stats *stats = get_hint_stats(hint);
+
+    if (hint_outcome == HINT_OUTCOME_FAILED)
+        atomic_fetch_add_explicit(&stats->counts[HINT_STAT_FAILED], 1,
+                memory_order_relaxed);
+    else if (hint_outcome == HINT_OUTCOME_ACTED)
+        atomic_fetch_add_explicit(&stats->counts[HINT_STAT_HANDLED], 1,
+                memory_order_relaxed);
+
+    record_latency(&stats->latency, start_us);
+    hint_outcome = HINT_OUTCOME_NONE;
+}
+
+void perflock_stats_acquire(long long start_us, int failed)
+{
+    record_latency(&perflock_latency, start_us);
+
+    atomic_fetch_add_explicit(&perflock_acquires, 1, memory_order_relaxed);
+    if (failed)
+        atomic_fetch_add_explicit(&perflock_failures, 1, memory_order_relaxed);
+}
+
+void sysfs_stats_write_failed(void)
+{
+    atomic_fetch_add_explicit(&sysfs_write_failures, 1, memory_order_relaxed);
+}
+
+/* Logs all counters, one line per hint type that has been received. */
+void dump_hint_stats(void)
+{
+    char latency[80];
+    char line[256];
+    size_t i;
+    int j, len;
+
+    for (i = 0; i < ARRAY_SIZE(hint_stats_table); i++) {
+        struct hint_stats *stats = &hint_stats_table[i];
+
+        if (!atomic_load_explicit(&stats->counts[HINT_STAT_RECEIVED],
+                memory_order_relaxed))
+            continue;
+
+        len = snprintf(line, sizeof(line), "%s:", stats->name);
+        for (j = 0; j < HINT_STAT_COUNT && len < (int)sizeof(line); j++) {
+            len += snprintf(line + len, sizeof(line) - len, " %s=%u",
+                    hint_stat_names[j],
+                    atomic_load_explicit(&stats->counts[j],
+                            memory_order_relaxed));
+        }
+
+        format_latency(latency, sizeof(latency), &stats->latency);
+        ALOGI("Hint stats %s%s", line, latency);
+    }
+
+    format_latency(latency, sizeof(latency), &perflock_latency);
+    ALOGI("Perflock stats: acquired=%u failed=%u%s",
+            atomic_load_explicit(&perflock_acquires, memory_order_relaxed),
+            atomic_load_explicit(&perflock_failures, memory_order_relaxed),
+            latency);
+    ALOGI("Sysfs stats: write_failed=%u",
+            atomic_load_explicit(&sysfs_write_failures, memory_order_relaxed));
+}
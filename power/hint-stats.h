@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2017 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _QCOM_HINT_STATS_H
+#define _QCOM_HINT_STATS_H
+
+#include <hardware/power.h>
+
+enum hint_stat {
+    HINT_STAT_RECEIVED,
+    HINT_STAT_DEBOUNCED,
+    HINT_STAT_MERGED,
+    HINT_STAT_HANDLED,
+    HINT_STAT_FAILED,
+    HINT_STAT_COUNT,
+};
+
+long long hint_stats_now_us(void);
+void hint_stats_inc(power_hint_t hint, enum hint_stat stat);
+void hint_stats_begin(void);
+void hint_stats_action(int failed);
+void hint_stats_end(power_hint_t hint, long long start_us);
+void perflock_stats_acquire(long long start_us, int failed);
+void sysfs_stats_write_failed(void);
+void dump_hint_stats(void);
+
+#endif
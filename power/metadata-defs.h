@@ -27,23 +27,46 @@
  *
  */
 
+#include <stddef.h>
+
 #define ATTRIBUTE_VALUE_DELIM ('=')
-#define ATTRIBUTE_STRING_DELIM (";")
+#define ATTRIBUTE_STRING_DELIM (';')
 
 #define METADATA_PARSING_ERR (-1)
-#define METADATA_PARSING_CONTINUE (0)
-#define METADATA_PARSING_DONE (1)
 
-#define MIN(x,y) (((x)>(y))?(y):(x))
+/*
+ * Describes one integer attribute of a metadata struct: the key it is
+ * read from and where the value goes.
+ */
+struct metadata_field {
+    const char *name;
+    size_t name_len;
+    size_t offset;
+};
 
+#define METADATA_FIELD(type, field) \
+    { #field, sizeof(#field) - 1, offsetof(type, field) }
+
+/*
+ * Video sessions may also describe the stream: frame size, frame rate and
+ * the client's codec id. Attributes that aren't sent are left as 0.
+ */
 struct video_encode_metadata_t {
     int hint_id;
     int state;
+    int width;
+    int height;
+    int fps;
+    int codec;
 };
 
 struct video_decode_metadata_t {
     int hint_id;
     int state;
+    int width;
+    int height;
+    int fps;
+    int codec;
 };
 
 struct audio_metadata_t {
@@ -56,14 +79,13 @@ struct cam_preview_metadata_t {
     int state;
 };
 
-int parse_metadata(char *metadata, char **metadata_saveptr,
-    char *attribute, int attribute_size, char *value,
-    unsigned int value_size);
-int parse_video_encode_metadata(char *metadata,
+int parse_metadata(const char *metadata, const struct metadata_field *fields,
+    int num_fields, void *out);
+int parse_video_encode_metadata(const char *metadata,
     struct video_encode_metadata_t *video_encode_metadata);
-int parse_video_decode_metadata(char *metadata,
+int parse_video_decode_metadata(const char *metadata,
     struct video_decode_metadata_t *video_decode_metadata);
-int parse_audio_metadata(char *metadata,
+int parse_audio_metadata(const char *metadata,
     struct audio_metadata_t *audio_metadata);
-int parse_cam_preview_metadata(char *metadata,
-    struct cam_preview_metadata_t *video_decode_metadata);
+int parse_cam_preview_metadata(const char *metadata,
+    struct cam_preview_metadata_t *cam_preview_metadata);
@@ -27,172 +27,161 @@
  *
  */
 
-#include <stdio.h>
-#include <string.h>
+#define LOG_NIDEBUG 0
+
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
 #include <stdlib.h>
+#include <string.h>
 
-#include "metadata-defs.h"
+#define LOG_TAG "QCOM PowerHAL"
+#include <utils/Log.h>
 
-int parse_metadata(char *metadata, char **metadata_saveptr,
-        char *attribute, int attribute_size, char *value,
-        unsigned int value_size)
-{
-    char *attribute_string;
-    char *attribute_value_delim;
-    unsigned int bytes_to_copy;
-
-    attribute_string = strtok_r(metadata, ATTRIBUTE_STRING_DELIM,
-            metadata_saveptr);
-
-    if (attribute_string == NULL)
-        return METADATA_PARSING_DONE;
-
-    attribute[0] = value[0] = '\0';
-
-    if ((attribute_value_delim = strchr(attribute_string,
-                    ATTRIBUTE_VALUE_DELIM)) != NULL) {
-        bytes_to_copy = MIN((attribute_value_delim - attribute_string),
-                attribute_size - 1);
-        /* Replace strncpy with strlcpy
-         * Add +1 to bytes_to_copy as strlcpy copies size-1 bytes */
-        strlcpy(attribute, attribute_string,
-                bytes_to_copy+1);
-
-        bytes_to_copy = MIN(strlen(attribute_string) - strlen(attribute) - 1,
-                value_size - 1);
-        /* Replace strncpy with strlcpy
-         * Add +1 to bytes_to_copy as strlcpy copies size-1 bytes */
-        strlcpy(value, attribute_value_delim + 1,
-                bytes_to_copy+1);
-    }
+#include "metadata-defs.h"
 
-    return METADATA_PARSING_CONTINUE;
-}
+#define ARRAY_SIZE(arr) (sizeof(arr) / sizeof(arr[0]))
 
-int parse_cam_preview_metadata(char *metadata,
-    struct cam_preview_metadata_t *cam_preview_metadata)
+/*
+ * Parses an int spanning [start, end): decimal, or hex with a 0x prefix.
+ * Surrounding whitespace is ignored and an empty value reads as 0, as it
+ * did with atoi().
+ */
+static int parse_int(const char *start, const char *end, int *value)
 {
-    char attribute[1024], value[1024], *saveptr;
-    char *temp_metadata = metadata;
-    int parsing_status;
-
-    while ((parsing_status = parse_metadata(temp_metadata, &saveptr,
-            attribute, sizeof(attribute), value, sizeof(value))) == METADATA_PARSING_CONTINUE) {
-        if (strlen(attribute) == strlen("hint_id") &&
-            (strncmp(attribute, "hint_id", strlen("hint_id")) == 0)) {
-            if (strlen(value) > 0) {
-                cam_preview_metadata->hint_id = atoi(value);
-            }
-        }
-
-        if (strlen(attribute) == strlen("state") &&
-            (strncmp(attribute, "state", strlen("state")) == 0)) {
-            if (strlen(value) > 0) {
-                cam_preview_metadata->state = atoi(value);
-            }
-        }
-
-        temp_metadata = NULL;
+    const char *digits;
+    char *parsed;
+    long result;
+    int base = 10;
+
+    while (start < end && isspace((unsigned char)*start))
+        start++;
+    while (end > start && isspace((unsigned char)end[-1]))
+        end--;
+
+    if (start == end) {
+        *value = 0;
+        return 0;
     }
 
-    if (parsing_status == METADATA_PARSING_ERR)
+    digits = start;
+    if (*digits == '-' || *digits == '+')
+        digits++;
+    if (end - digits > 2 && digits[0] == '0' &&
+            (digits[1] == 'x' || digits[1] == 'X'))
+        base = 16;
+
+    errno = 0;
+    result = strtol(start, &parsed, base);
+    if (parsed != end || errno == ERANGE ||
+            result < INT_MIN || result > INT_MAX)
         return -1;
 
+    *value = result;
+
     return 0;
 }
 
-int parse_video_encode_metadata(char *metadata,
-    struct video_encode_metadata_t *video_encode_metadata)
+/*
+ * Parses "key=value;key=value..." in a single pass without copying or
+ * modifying the string. Each key listed in fields has its integer value
+ * stored at the field's offset in out; other keys and tokens without '='
+ * are skipped. A known key with a non-numeric value is an error; an empty
+ * one reads as 0.
+ *
+ * Returns 0 on success or METADATA_PARSING_ERR.
+ */
+int parse_metadata(const char *metadata, const struct metadata_field *fields,
+        int num_fields, void *out)
 {
-    char attribute[1024], value[1024], *saveptr;
-    char *temp_metadata = metadata;
-    int parsing_status;
-
-    while ((parsing_status = parse_metadata(temp_metadata, &saveptr,
-            attribute, sizeof(attribute), value, sizeof(value))) == METADATA_PARSING_CONTINUE) {
-        if (strlen(attribute) == strlen("hint_id") &&
-            (strncmp(attribute, "hint_id", strlen("hint_id")) == 0)) {
-            if (strlen(value) > 0) {
-                video_encode_metadata->hint_id = atoi(value);
-            }
+    const char *attribute = metadata;
+
+    while (*attribute) {
+        const char *delim = NULL;
+        const char *end;
+        int i;
+
+        for (end = attribute; *end && *end != ATTRIBUTE_STRING_DELIM; end++) {
+            if (!delim && *end == ATTRIBUTE_VALUE_DELIM)
+                delim = end;
         }
 
-        if (strlen(attribute) == strlen("state") &&
-            (strncmp(attribute, "state", strlen("state")) == 0)) {
-            if (strlen(value) > 0) {
-                video_encode_metadata->state = atoi(value);
+        if (delim) {
+            size_t name_len = delim - attribute;
+
+            for (i = 0; i < num_fields; i++) {
+                if (fields[i].name_len != name_len ||
+                        memcmp(fields[i].name, attribute, name_len) != 0)
+                    continue;
+
+                if (parse_int(delim + 1, end,
+                        (int *)((char *)out + fields[i].offset))) {
+                    ALOGE("Invalid value for metadata attribute %s: %.*s",
+                            fields[i].name, (int)(end - delim - 1), delim + 1);
+                    return METADATA_PARSING_ERR;
+                }
+                break;
             }
         }
 
-        temp_metadata = NULL;
+        attribute = *end ? end + 1 : end;
     }
 
-    if (parsing_status == METADATA_PARSING_ERR)
-        return -1;
-
     return 0;
 }
 
-int parse_video_decode_metadata(char *metadata,
-    struct video_decode_metadata_t *video_decode_metadata)
+static const struct metadata_field cam_preview_fields[] = {
+    METADATA_FIELD(struct cam_preview_metadata_t, hint_id),
+    METADATA_FIELD(struct cam_preview_metadata_t, state),
+};
+
+static const struct metadata_field video_encode_fields[] = {
+    METADATA_FIELD(struct video_encode_metadata_t, hint_id),
+    METADATA_FIELD(struct video_encode_metadata_t, state),
+    METADATA_FIELD(struct video_encode_metadata_t, width),
+    METADATA_FIELD(struct video_encode_metadata_t, height),
+    METADATA_FIELD(struct video_encode_metadata_t, fps),
+    METADATA_FIELD(struct video_encode_metadata_t, codec),
+};
+
+static const struct metadata_field video_decode_fields[] = {
+    METADATA_FIELD(struct video_decode_metadata_t, hint_id),
+    METADATA_FIELD(struct video_decode_metadata_t, state),
+    METADATA_FIELD(struct video_decode_metadata_t, width),
+    METADATA_FIELD(struct video_decode_metadata_t, height),
+    METADATA_FIELD(struct video_decode_metadata_t, fps),
+    METADATA_FIELD(struct video_decode_metadata_t, codec),
+};
+
+static const struct metadata_field audio_fields[] = {
+    METADATA_FIELD(struct audio_metadata_t, hint_id),
+    METADATA_FIELD(struct audio_metadata_t, state),
+};
+
+int parse_cam_preview_metadata(const char *metadata,
+    struct cam_preview_metadata_t *cam_preview_metadata)
 {
-    char attribute[1024], value[1024], *saveptr;
-    char *temp_metadata = metadata;
-    int parsing_status;
-
-    while ((parsing_status = parse_metadata(temp_metadata, &saveptr,
-            attribute, sizeof(attribute), value, sizeof(value))) == METADATA_PARSING_CONTINUE) {
-        if (strlen(attribute) == strlen("hint_id") &&
-            (strncmp(attribute, "hint_id", strlen("hint_id")) == 0)) {
-            if (strlen(value) > 0) {
-                video_decode_metadata->hint_id = atoi(value);
-            }
-        }
-
-        if (strlen(attribute) == strlen("state") &&
-            (strncmp(attribute, "state", strlen("state")) == 0)) {
-            if (strlen(value) > 0) {
-                video_decode_metadata->state = atoi(value);
-            }
-        }
-
-        temp_metadata = NULL;
-    }
+    return parse_metadata(metadata, cam_preview_fields,
+            ARRAY_SIZE(cam_preview_fields), cam_preview_metadata);
+}
 
-    if (parsing_status == METADATA_PARSING_ERR)
-        return -1;
+int parse_video_encode_metadata(const char *metadata,
+    struct video_encode_metadata_t *video_encode_metadata)
+{
+    return parse_metadata(metadata, video_encode_fields,
+            ARRAY_SIZE(video_encode_fields), video_encode_metadata);
+}
 
-    return 0;
+int parse_video_decode_metadata(const char *metadata,
+    struct video_decode_metadata_t *video_decode_metadata)
+{
+    return parse_metadata(metadata, video_decode_fields,
+            ARRAY_SIZE(video_decode_fields), video_decode_metadata);
 }
 
-int parse_audio_metadata(char *metadata,
+int parse_audio_metadata(const char *metadata,
     struct audio_metadata_t *audio_metadata)
 {
-    char attribute[1024], value[1024], *saveptr;
-    char *temp_metadata = metadata;
-    int parsing_status;
-
-    while ((parsing_status = parse_metadata(temp_metadata, &saveptr,
-            attribute, sizeof(attribute), value, sizeof(value))) == METADATA_PARSING_CONTINUE) {
-        if (strlen(attribute) == strlen("hint_id") &&
-            (strncmp(attribute, "hint_id", strlen("hint_id")) == 0)) {
-            if (strlen(value) > 0) {
-                audio_metadata->hint_id = atoi(value);
-            }
-        }
-
-        if (strlen(attribute) == strlen("state") &&
-            (strncmp(attribute, "state", strlen("state")) == 0)) {
-            if (strlen(value) > 0) {
-                audio_metadata->state = atoi(value);
-            }
-        }
-
-        temp_metadata = NULL;
-    }
-
-    if (parsing_status == METADATA_PARSING_ERR)
-        return -1;
-
-    return 0;
+    return parse_metadata(metadata, audio_fields,
+            ARRAY_SIZE(audio_fields), audio_metadata);
 }
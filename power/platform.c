@@ -0,0 +1,304 @@
+/*
+ * Copyright (C) 2017 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NIDEBUG 0
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOG_TAG "QCOM PowerHAL"
+#include <utils/Log.h>
+
+#include "platform.h"
+#include "utils.h"
+
+#define SOC_ID_0 "/sys/devices/soc0/soc_id"
+#define SOC_ID_1 "/sys/devices/system/soc/soc0/id"
+#define CPU_POSSIBLE "/sys/devices/system/cpu/possible"
+#define CPUFREQ_NODE "/sys/devices/system/cpu/cpu%d/cpufreq/%s"
+
+static struct platform_info platform;
+static pthread_once_t platform_once = PTHREAD_ONCE_INIT;
+
+/* Clusters with no CPU present at probe time, probed again on use. */
+static struct cpu_info late_cluster_info[MAX_CLUSTERS];
+static atomic_int late_cluster_probed[MAX_CLUSTERS];
+static pthread_mutex_t late_probe_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int read_int_node(const char *path, int *value)
+{
+    char buf[32];
+
+    if (sysfs_read_once(path, buf, sizeof(buf)))
+        return -1;
+
+    *value = atoi(buf);
+
+    return 0;
+}
+
+static int read_cpufreq_int(int cpu, const char *node, int *value)
+{
+    char path[80];
+
+    snprintf(path, sizeof(path), CPUFREQ_NODE, cpu, node);
+
+    return read_int_node(path, value);
+}
+
+/* Parses "0-7" or "0"; returns the number of CPUs. */
+static int probe_num_cpus(void)
+{
+    char buf[32];
+    char *end;
+    int last;
+
+    if (sysfs_read_once(CPU_POSSIBLE, buf, sizeof(buf)))
+        return MAX_CPUS;
+
+    end = strchr(buf, '-');
+    last = end ? atoi(end + 1) : atoi(buf);
+
+    if (last < 0 || last >= MAX_CPUS)
+        return MAX_CPUS;
+
+    return last + 1;
+}
+
+static void probe_cpu(int cpu, struct cpu_info *info)
+{
+    char path[80];
+    char buf[512];
+    char *pos, *end;
+
+    if (read_cpufreq_int(cpu, "cpuinfo_min_freq", &info->min_freq) ||
+            read_cpufreq_int(cpu, "cpuinfo_max_freq", &info->max_freq))
+        return;
+
+    info->present = 1;
+
+    snprintf(path, sizeof(path), CPUFREQ_NODE, cpu,
+            "scaling_available_frequencies");
+    if (sysfs_read_once(path, buf, sizeof(buf)))
+        return;
+
+    for (pos = buf; info->num_freqs < MAX_CPU_FREQS; pos = end) {
+        long freq = strtol(pos, &end, 10);
+
+        if (end == pos)
+            break;
+
+        info->freqs[info->num_freqs++] = freq;
+    }
+}
+
+/* Parses a cpu list such as "0 1 2 3" or "0-3" into a mask. */
+static unsigned int parse_cpu_list(const char *list)
+{
+    unsigned int mask = 0;
+    const char *pos = list;
+    char *end;
+
+    for (;;) {
+        long first, last;
+
+        while (*pos == ' ' || *pos == ',')
+            pos++;
+
+        first = strtol(pos, &end, 10);
+        if (end == pos)
+            break;
+
+        last = first;
+        if (*end == '-') {
+            pos = end + 1;
+            last = strtol(pos, &end, 10);
+            if (end == pos)
+                break;
+        }
+        pos = end;
+
+        for (; first <= last && first < MAX_CPUS; first++) {
+            if (first >= 0)
+                mask |= 1u << first;
+        }
+    }
+
+    return mask;
+}
+
+/*
+ * Groups CPUs by cpufreq policy. Offline CPUs are picked up through the
+ * related_cpus of an online sibling; a CPU no policy claims gets a cluster
+ * of its own. Clusters are ordered by their first CPU.
+ */
+static void probe_clusters(void)
+{
+    unsigned int masks[MAX_CPUS];
+    unsigned int seen = 0;
+    char path[80];
+    char buf[64];
+    int num_masks = 0;
+    int cpu, i, j;
+
+    for (cpu = 0; cpu < platform.num_cpus; cpu++) {
+        unsigned int mask;
+
+        if (seen & (1u << cpu))
+            continue;
+
+        snprintf(path, sizeof(path), CPUFREQ_NODE, cpu, "related_cpus");
+        if (sysfs_read_once(path, buf, sizeof(buf)))
+            continue;
+
+        mask = parse_cpu_list(buf) & ((1u << platform.num_cpus) - 1) & ~seen;
+        mask |= 1u << cpu;
+
+        masks[num_masks++] = mask;
+        seen |= mask;
+    }
+
+    for (cpu = 0; cpu < platform.num_cpus; cpu++) {
+        if (!(seen & (1u << cpu)))
+            masks[num_masks++] = 1u << cpu;
+    }
+
+    /* Lowest set bit first; at most MAX_CPUS entries. */
+    for (i = 1; i < num_masks; i++) {
+        unsigned int mask = masks[i];
+
+        for (j = i; j > 0 &&
+                __builtin_ctz(masks[j - 1]) > __builtin_ctz(mask); j--)
+            masks[j] = masks[j - 1];
+        masks[j] = mask;
+    }
+
+    if (num_masks > MAX_CLUSTERS) {
+        ALOGE("More than %d CPU clusters", MAX_CLUSTERS);
+        num_masks = MAX_CLUSTERS;
+    }
+
+    for (i = 0; i < num_masks; i++) {
+        struct cluster_info *cluster = &platform.clusters[i];
+
+        cluster->cpu_mask = masks[i];
+        cluster->first_cpu = __builtin_ctz(masks[i]);
+        cluster->num_cpus = __builtin_popcount(masks[i]);
+        cluster->freq_cpu = -1;
+
+        for (cpu = 0; cpu < platform.num_cpus; cpu++) {
+            if (!(masks[i] & (1u << cpu)))
+                continue;
+
+            platform.cpus[cpu].cluster = i;
+            if (cluster->freq_cpu < 0 && platform.cpus[cpu].present)
+                cluster->freq_cpu = cpu;
+        }
+    }
+
+    platform.num_clusters = num_masks;
+}
+
+static void probe_platform(void)
+{
+    int cpu;
+
+    if (read_int_node(SOC_ID_0, &platform.soc_id) &&
+            read_int_node(SOC_ID_1, &platform.soc_id)) {
+        ALOGW("Unable to read soc_id");
+        platform.soc_id = -1;
+    }
+
+    platform.num_cpus = probe_num_cpus();
+
+    for (cpu = 0; cpu < platform.num_cpus; cpu++)
+        probe_cpu(cpu, &platform.cpus[cpu]);
+
+    probe_clusters();
+
+    ALOGI("SoC %d with %d CPUs in %d clusters", platform.soc_id,
+            platform.num_cpus, platform.num_clusters);
+}
+
+/*
+ * Returns the platform description, probing sysfs on the first call. A
+ * host build that relocates sysfs must call set_sysfs_root() first.
+ */
+const struct platform_info *get_platform_info(void)
+{
+    pthread_once(&platform_once, probe_platform);
+
+    return &platform;
+}
+
+/*
+ * Returns the cpufreq limits and frequencies of a cluster, taken from any
+ * of its CPUs that was present at probe time. If the whole cluster was
+ * offline then, its CPUs are probed again until one answers; NULL until
+ * that happens.
+ */
+const struct cpu_info *get_cluster_cpu_info(int cluster)
+{
+    const struct platform_info *info = get_platform_info();
+    const struct cluster_info *cluster_info;
+    int cpu;
+
+    if (cluster < 0 || cluster >= info->num_clusters)
+        return NULL;
+
+    cluster_info = &info->clusters[cluster];
+    if (cluster_info->freq_cpu >= 0)
+        return &info->cpus[cluster_info->freq_cpu];
+
+    if (atomic_load_explicit(&late_cluster_probed[cluster],
+            memory_order_acquire))
+        return &late_cluster_info[cluster];
+
+    pthread_mutex_lock(&late_probe_lock);
+
+    for (cpu = 0; cpu < info->num_cpus &&
+            !atomic_load_explicit(&late_cluster_probed[cluster],
+                    memory_order_relaxed); cpu++) {
+        struct cpu_info probed;
+
+        if (!(cluster_info->cpu_mask & (1u << cpu)))
+            continue;
+
+        memset(&probed, 0, sizeof(probed));
+        probe_cpu(cpu, &probed);
+        if (!probed.present)
+            continue;
+
+        probed.cluster = cluster;
+        late_cluster_info[cluster] = probed;
+        atomic_store_explicit(&late_cluster_probed[cluster], 1,
+                memory_order_release);
+        ALOGI("Probed cluster %d through cpu%d", cluster, cpu);
+    }
+
+    pthread_mutex_unlock(&late_probe_lock);
+
+    return atomic_load_explicit(&late_cluster_probed[cluster],
+            memory_order_acquire) ? &late_cluster_info[cluster] : NULL;
+}
+
+int get_soc_id(void)
+{
+    return get_platform_info()->soc_id;
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2017 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _QCOM_PLATFORM_H
+#define _QCOM_PLATFORM_H
+
+#define MAX_CPUS 8
+#define MAX_CLUSTERS 4
+#define MAX_CPU_FREQS 32
+
+struct cpu_info {
+    /* cpufreq policy was readable when probed. */
+    int present;
+    /* Index into platform_info.clusters. */
+    int cluster;
+    /* cpuinfo_{min,max}_freq in kHz. */
+    int min_freq;
+    int max_freq;
+    /* scaling_available_frequencies in kHz, ascending. */
+    int num_freqs;
+    int freqs[MAX_CPU_FREQS];
+};
+
+/* CPUs sharing one cpufreq policy, as listed in related_cpus. */
+struct cluster_info {
+    int first_cpu;
+    int num_cpus;
+    unsigned int cpu_mask;
+    /* A CPU of the cluster that was present when probed, or -1. */
+    int freq_cpu;
+};
+
+/*
+ * Static facts about the SoC, probed once and never modified afterwards.
+ * The scaling governor is not part of it, since it can change at runtime;
+ * use get_scaling_governor_type() for that.
+ */
+struct platform_info {
+    int soc_id;
+    int num_cpus;
+    struct cpu_info cpus[MAX_CPUS];
+    int num_clusters;
+    struct cluster_info clusters[MAX_CLUSTERS];
+};
+
+const struct platform_info *get_platform_info(void);
+const struct cpu_info *get_cluster_cpu_info(int cluster);
+
+#endif
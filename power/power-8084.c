@@ -35,6 +35,7 @@
 #include <fcntl.h>
 #include <dlfcn.h>
 #include <stdlib.h>
+#include <stdatomic.h>
 
 #define LOG_TAG "QCOM PowerHAL"
 #include <utils/Log.h>
@@ -46,6 +47,7 @@
 #include "hint-data.h"
 #include "performance.h"
 #include "power-common.h"
+#include "boost-config.h"
 
 static int first_display_off_hint;
 
@@ -53,7 +55,29 @@ int get_number_of_profiles() {
     return 3;
 }
 
-static int current_power_profile = PROFILE_BALANCED;
+static atomic_int current_power_profile = PROFILE_BALANCED;
+
+static const int profile_high_performance[] = {
+    CPUS_ONLINE_MIN_4,
+    CPU0_MIN_FREQ_TURBO_MAX, CPU1_MIN_FREQ_TURBO_MAX,
+    CPU2_MIN_FREQ_TURBO_MAX, CPU3_MIN_FREQ_TURBO_MAX,
+};
+
+static const int profile_power_save[] = {
+    CPUS_ONLINE_MAX_LIMIT_2,
+    CPU0_MAX_FREQ_NONTURBO_MAX, CPU1_MAX_FREQ_NONTURBO_MAX,
+    CPU2_MAX_FREQ_NONTURBO_MAX, CPU3_MAX_FREQ_NONTURBO_MAX,
+};
+
+static const int resources_cpu_boost[] = {
+    CPUS_ONLINE_MIN_2, 0x20B, 0x30B, 0x1C00,
+};
+
+static const struct resource_list builtin_boost_lists[BOOST_LIST_COUNT] = {
+    [BOOST_CPU_BOOST] = RESOURCE_LIST(resources_cpu_boost),
+    [BOOST_PROFILE_POWER_SAVE] = RESOURCE_LIST(profile_power_save),
+    [BOOST_PROFILE_HIGH_PERFORMANCE] = RESOURCE_LIST(profile_high_performance),
+};
 
 static void set_power_profile(int profile) {
 
@@ -62,32 +86,24 @@ static void set_power_profile(int profile) {
 
     ALOGV("%s: profile=%d", __func__, profile);
 
-    if (current_power_profile != PROFILE_BALANCED) {
-        undo_hint_action(DEFAULT_PROFILE_HINT_ID);
-        ALOGV("%s: hint undone", __func__);
-    }
-
     if (profile == PROFILE_HIGH_PERFORMANCE) {
-        int resource_values[] = { CPUS_ONLINE_MIN_4,
-            CPU0_MIN_FREQ_TURBO_MAX, CPU1_MIN_FREQ_TURBO_MAX,
-            CPU2_MIN_FREQ_TURBO_MAX, CPU3_MIN_FREQ_TURBO_MAX };
-        perform_hint_action(DEFAULT_PROFILE_HINT_ID,
-            resource_values, ARRAY_SIZE(resource_values));
+        configured_hint_action(BOOST_PROFILE_HIGH_PERFORMANCE,
+                DEFAULT_PROFILE_HINT_ID, builtin_boost_lists);
         ALOGD("%s: set performance mode", __func__);
 
     } else if (profile == PROFILE_POWER_SAVE) {
-        int resource_values[] = { CPUS_ONLINE_MAX_LIMIT_2,
-            CPU0_MAX_FREQ_NONTURBO_MAX, CPU1_MAX_FREQ_NONTURBO_MAX,
-            CPU2_MAX_FREQ_NONTURBO_MAX, CPU3_MAX_FREQ_NONTURBO_MAX };
-        perform_hint_action(DEFAULT_PROFILE_HINT_ID,
-            resource_values, ARRAY_SIZE(resource_values));
+        configured_hint_action(BOOST_PROFILE_POWER_SAVE,
+                DEFAULT_PROFILE_HINT_ID, builtin_boost_lists);
         ALOGD("%s: set powersave", __func__);
+    } else if (current_power_profile != PROFILE_BALANCED) {
+        undo_hint_action(DEFAULT_PROFILE_HINT_ID);
+        ALOGV("%s: hint undone", __func__);
     }
 
     current_power_profile = profile;
 }
 
-extern void interaction(int duration, int num_args, int opt_list[]);
+extern void interaction(int duration, int num_args, const int opt_list[]);
 
 int power_hint_override(__attribute__((unused)) struct power_module *module,
         power_hint_t hint, void *data)
@@ -104,10 +120,10 @@ int power_hint_override(__attribute__((unused)) struct power_module *module,
 
 	if (hint == POWER_HINT_CPU_BOOST) {
         int duration = *(int32_t *)data / 1000;
-        int resources[] = { CPUS_ONLINE_MIN_2, 0x20B, 0x30B, 0x1C00};
 
         if (duration > 0)
-            interaction(duration, ARRAY_SIZE(resources), resources);
+            configured_interaction(BOOST_CPU_BOOST, duration,
+                    builtin_boost_lists);
 
         return HINT_HANDLED;
 	}
@@ -115,11 +131,19 @@ int power_hint_override(__attribute__((unused)) struct power_module *module,
 	return HINT_NONE;
 }
 
+static const int display_off_ondemand_resources[] = {
+    MS_500, SYNC_FREQ_600, OPTIMAL_FREQ_600, THREAD_MIGRATION_SYNC_OFF,
+};
+
+static const int display_on_resources[] = {
+    CPUS_ONLINE_MIN_2,
+};
+
 int set_interactive_override(struct power_module *module, int on)
 {
-    char governor[80];
+    int governor;
 
-    if (get_scaling_governor(governor, sizeof(governor)) == -1) {
+    if ((governor = get_scaling_governor_type()) == GOVERNOR_UNKNOWN) {
         ALOGE("Can't obtain scaling governor.");
 
         return HINT_NONE;
@@ -138,23 +162,19 @@ int set_interactive_override(struct power_module *module, int on)
         /* Used for all subsequent toggles to the display */
         undo_hint_action(DISPLAY_STATE_HINT_ID_2);
 
-        if ((strncmp(governor, ONDEMAND_GOVERNOR, strlen(ONDEMAND_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(ONDEMAND_GOVERNOR))) {
-            int resource_values[] = {MS_500, SYNC_FREQ_600, OPTIMAL_FREQ_600, THREAD_MIGRATION_SYNC_OFF};
-
+        if (governor == GOVERNOR_ONDEMAND) {
             perform_hint_action(DISPLAY_STATE_HINT_ID,
-                    resource_values, ARRAY_SIZE(resource_values));
+                    display_off_ondemand_resources,
+                    ARRAY_SIZE(display_off_ondemand_resources));
 
             return HINT_HANDLED;
         }
     } else {
         /* Display on */
-        int resource_values2[] = { CPUS_ONLINE_MIN_2 };
         perform_hint_action(DISPLAY_STATE_HINT_ID_2,
-                resource_values2, ARRAY_SIZE(resource_values2));
+                display_on_resources, ARRAY_SIZE(display_on_resources));
 
-        if ((strncmp(governor, ONDEMAND_GOVERNOR, strlen(ONDEMAND_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(ONDEMAND_GOVERNOR))) {
+        if (governor == GOVERNOR_ONDEMAND) {
             undo_hint_action(DISPLAY_STATE_HINT_ID);
 
             return HINT_HANDLED;
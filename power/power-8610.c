@@ -36,6 +36,7 @@
 #include <fcntl.h>
 #include <dlfcn.h>
 #include <stdlib.h>
+#include <stdatomic.h>
 
 #define LOG_TAG "QCOM PowerHAL"
 #include <utils/Log.h>
@@ -47,12 +48,38 @@
 #include "hint-data.h"
 #include "performance.h"
 #include "power-common.h"
+#include "boost-config.h"
 
 int get_number_of_profiles() {
     return 3;
 }
 
-static int current_power_profile = PROFILE_BALANCED;
+static atomic_int current_power_profile = PROFILE_BALANCED;
+
+static const int profile_high_performance[] = {
+    CPUS_ONLINE_MIN_2,
+    CPU0_MIN_FREQ_TURBO_MAX, CPU1_MIN_FREQ_TURBO_MAX,
+};
+
+static const int profile_power_save[] = {
+    CPUS_ONLINE_MAX_LIMIT_2,
+    CPU0_MAX_FREQ_NONTURBO_MAX, CPU1_MAX_FREQ_NONTURBO_MAX,
+};
+
+static const int resources_cpu_boost[] = {
+    CPUS_ONLINE_MIN_2, 0x20F, 0x30F,
+};
+
+static const int resources_interaction[] = {
+    0x702, 0x20B, 0x30B,
+};
+
+static const struct resource_list builtin_boost_lists[BOOST_LIST_COUNT] = {
+    [BOOST_INTERACTION] = RESOURCE_LIST(resources_interaction),
+    [BOOST_CPU_BOOST] = RESOURCE_LIST(resources_cpu_boost),
+    [BOOST_PROFILE_POWER_SAVE] = RESOURCE_LIST(profile_power_save),
+    [BOOST_PROFILE_HIGH_PERFORMANCE] = RESOURCE_LIST(profile_high_performance),
+};
 
 static void set_power_profile(int profile) {
 
@@ -61,29 +88,23 @@ static void set_power_profile(int profile) {
 
     ALOGV("%s: profile=%d", __func__, profile);
 
-    if (current_power_profile != PROFILE_BALANCED) {
-        undo_hint_action(DEFAULT_PROFILE_HINT_ID);
-        ALOGV("%s: hint undone", __func__);
-    }
-
     if (profile == PROFILE_HIGH_PERFORMANCE) {
-        int resource_values[] = { CPUS_ONLINE_MIN_2,
-            CPU0_MIN_FREQ_TURBO_MAX, CPU1_MIN_FREQ_TURBO_MAX };
-        perform_hint_action(DEFAULT_PROFILE_HINT_ID,
-            resource_values, ARRAY_SIZE(resource_values));
+        configured_hint_action(BOOST_PROFILE_HIGH_PERFORMANCE,
+                DEFAULT_PROFILE_HINT_ID, builtin_boost_lists);
         ALOGD("%s: set performance mode", __func__);
     } else if (profile == PROFILE_POWER_SAVE) {
-        int resource_values[] = { CPUS_ONLINE_MAX_LIMIT_2,
-            CPU0_MAX_FREQ_NONTURBO_MAX, CPU1_MAX_FREQ_NONTURBO_MAX };
-        perform_hint_action(DEFAULT_PROFILE_HINT_ID,
-            resource_values, ARRAY_SIZE(resource_values));
+        configured_hint_action(BOOST_PROFILE_POWER_SAVE,
+                DEFAULT_PROFILE_HINT_ID, builtin_boost_lists);
         ALOGD("%s: set powersave", __func__);
+    } else if (current_power_profile != PROFILE_BALANCED) {
+        undo_hint_action(DEFAULT_PROFILE_HINT_ID);
+        ALOGV("%s: hint undone", __func__);
     }
 
     current_power_profile = profile;
 }
 
-extern void interaction(int duration, int num_args, int opt_list[]);
+extern void interaction(int duration, int num_args, const int opt_list[]);
 
 int power_hint_override(__attribute__((unused)) struct power_module *module,
         power_hint_t hint, void *data)
@@ -100,16 +121,16 @@ int power_hint_override(__attribute__((unused)) struct power_module *module,
 
     if (hint == POWER_HINT_CPU_BOOST) {
         int duration = *(int32_t *)data / 1000;
-        int resources[] = { CPUS_ONLINE_MIN_2, 0x20F, 0x30F};
 
         if (duration > 0)
-            interaction(duration, ARRAY_SIZE(resources), resources);
+            configured_interaction(BOOST_CPU_BOOST, duration,
+                    builtin_boost_lists);
         return HINT_HANDLED;
     } else if (hint == POWER_HINT_INTERACTION) {
-        int resources[] = {0x702, 0x20B, 0x30B};
         int duration = 3000;
 
-        interaction(duration, ARRAY_SIZE(resources), resources);
+        configured_interaction(BOOST_INTERACTION, duration,
+                builtin_boost_lists);
         return HINT_HANDLED;
     }
 
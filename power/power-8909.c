@@ -46,56 +46,25 @@
 #include "hint-data.h"
 #include "performance.h"
 #include "power-common.h"
+#include "video-hint.h"
 
 
-static void process_video_encode_hint(void *metadata)
-{
-    char governor[80];
-    struct video_encode_metadata_t video_encode_metadata;
-    char tmp_str[NODE_MAX];
-
-    if (get_scaling_governor(governor, sizeof(governor)) == -1) {
-        ALOGE("Can't obtain scaling governor.");
-
-        return;
-    }
-
-    /* Initialize encode metadata struct fields. */
-    memset(&video_encode_metadata, 0, sizeof(struct video_encode_metadata_t));
-    video_encode_metadata.state = -1;
-    video_encode_metadata.hint_id = DEFAULT_VIDEO_ENCODE_HINT_ID;
-
-    if (metadata) {
-        if (parse_video_encode_metadata((char *)metadata, &video_encode_metadata) ==
-            -1) {
-            ALOGE("Error occurred while parsing metadata.");
-            return;
-        }
-    } else {
-        return;
-    }
+static const int video_encode_interactive[] = {
+    HS_FREQ_800, THREAD_MIGRATION_SYNC_OFF,
+};
 
-    if (video_encode_metadata.state == 1) {
-        if ((strncmp(governor, INTERACTIVE_GOVERNOR, strlen(INTERACTIVE_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(INTERACTIVE_GOVERNOR))) {
-            int resource_values[] = {HS_FREQ_800, THREAD_MIGRATION_SYNC_OFF};
-            perform_hint_action(video_encode_metadata.hint_id,
-                    resource_values, ARRAY_SIZE(resource_values));
-        }
-    } else if (video_encode_metadata.state == 0) {
-         if ((strncmp(governor, INTERACTIVE_GOVERNOR, strlen(INTERACTIVE_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(INTERACTIVE_GOVERNOR))) {
-           undo_hint_action(video_encode_metadata.hint_id);
-        }
-    }
-}
+static const struct video_hint_resources video_hint_table[] = {
+    VIDEO_HINT_RESOURCES(POWER_HINT_VIDEO_ENCODE, GOVERNOR_INTERACTIVE,
+            video_encode_interactive),
+};
 
 int power_hint_override(struct power_module *module, power_hint_t hint, void *data)
 {
     switch(hint) {
         case POWER_HINT_VIDEO_ENCODE:
         {
-          process_video_encode_hint(data);
+          process_video_hint(hint, data, video_hint_table,
+                  ARRAY_SIZE(video_hint_table));
           return HINT_HANDLED;
         }
         default:
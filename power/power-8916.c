@@ -36,6 +36,7 @@
 #include <fcntl.h>
 #include <dlfcn.h>
 #include <stdlib.h>
+#include <stdatomic.h>
 
 #define LOG_TAG "QCOM PowerHAL"
 #include <utils/Log.h>
@@ -47,24 +48,17 @@
 #include "hint-data.h"
 #include "performance.h"
 #include "power-common.h"
+#include "video-hint.h"
+#include "boost-config.h"
 
 #define MIN_FREQ_CPU0_DISP_OFF 400000
 #define MIN_FREQ_CPU0_DISP_ON  960000
 
-char scaling_min_freq[4][80] ={
-    "sys/devices/system/cpu/cpu0/cpufreq/scaling_min_freq",
-    "sys/devices/system/cpu/cpu1/cpufreq/scaling_min_freq",
-    "sys/devices/system/cpu/cpu2/cpufreq/scaling_min_freq",
-    "sys/devices/system/cpu/cpu3/cpufreq/scaling_min_freq"
-};
-
-static int slack_node_rw_failed = 0;
-
 int get_number_of_profiles() {
     return 3;
 }
 
-static int current_power_profile = PROFILE_BALANCED;
+static atomic_int current_power_profile = PROFILE_BALANCED;
 
 /**
  * If target is 8916:
@@ -74,26 +68,16 @@ static int current_power_profile = PROFILE_BALANCED;
  */
 static int is_target_8916(void)
 {
-    static int is_8916 = -1;
-    int soc_id;
+    int soc_id = get_soc_id();
 
-    if (is_8916 >= 0)
-        return is_8916;
-
-    soc_id = get_soc_id();
-    if (soc_id == 206 || (soc_id >= 247 && soc_id <= 250))
-        is_8916 = 1;
-    else
-        is_8916 = 0;
-
-    return is_8916;
+    return soc_id == 206 || (soc_id >= 247 && soc_id <= 250);
 }
 
-static int profile_high_performance_8916[3] = {
+static const int profile_high_performance_8916[3] = {
     0x1C00, 0x0901, CPU0_MIN_FREQ_TURBO_MAX,
 };
 
-static int profile_high_performance_8939[11] = {
+static const int profile_high_performance_8939[11] = {
     SCHED_BOOST_ON, 0x1C00, 0x0901,
     CPU0_MIN_FREQ_TURBO_MAX, CPU1_MIN_FREQ_TURBO_MAX,
     CPU2_MIN_FREQ_TURBO_MAX, CPU3_MIN_FREQ_TURBO_MAX,
@@ -101,154 +85,127 @@ static int profile_high_performance_8939[11] = {
     CPU6_MIN_FREQ_TURBO_MAX, CPU7_MIN_FREQ_TURBO_MAX,
 };
 
-static int profile_power_save_8916[1] = {
+static const int profile_power_save_8916[1] = {
     CPU0_MAX_FREQ_NONTURBO_MAX,
 };
 
-static int profile_power_save_8939[5] = {
+static const int profile_power_save_8939[5] = {
     CPUS_ONLINE_MAX_LIMIT_2,
     CPU0_MAX_FREQ_NONTURBO_MAX, CPU1_MAX_FREQ_NONTURBO_MAX,
     CPU2_MAX_FREQ_NONTURBO_MAX, CPU3_MAX_FREQ_NONTURBO_MAX,
 };
 
-static void set_power_profile(int profile) {
-
-    if (profile == current_power_profile)
-        return;
-
-    ALOGV("%s: profile=%d", __func__, profile);
-
-    if (current_power_profile != PROFILE_BALANCED) {
-        undo_hint_action(DEFAULT_PROFILE_HINT_ID);
-        ALOGV("%s: hint undone", __func__);
-    }
+static const int resources_interaction_fling_boost[] = {
+    ALL_CPUS_PWR_CLPS_DIS,
+    SCHED_BOOST_ON,
+    SCHED_PREFER_IDLE_DIS,
+    0x20D,
+};
 
-    if (profile == PROFILE_HIGH_PERFORMANCE) {
-        int *resource_values = is_target_8916() ?
-            profile_high_performance_8916 : profile_high_performance_8939;
+static const int resources_interaction_boost[] = {
+    ALL_CPUS_PWR_CLPS_DIS,
+    SCHED_PREFER_IDLE_DIS,
+    0x20D,
+};
 
-        perform_hint_action(DEFAULT_PROFILE_HINT_ID,
-            resource_values, ARRAY_SIZE(resource_values));
-        ALOGD("%s: set performance mode", __func__);
+static const int resources_launch[] = {
+    ALL_CPUS_PWR_CLPS_DIS,
+    SCHED_BOOST_ON,
+    SCHED_PREFER_IDLE_DIS,
+    0x20F,
+    0x1C00,
+    0x4001,
+    0x4101,
+    0x4201,
+};
 
-    } else if (profile == PROFILE_POWER_SAVE) {
-        int* resource_values = is_target_8916() ?
-            profile_power_save_8916 : profile_power_save_8939;
+static const int resources_cpu_boost[] = {
+    ALL_CPUS_PWR_CLPS_DIS,
+    SCHED_BOOST_ON,
+    SCHED_PREFER_IDLE_DIS,
+    0x20D,
+};
 
-        perform_hint_action(DEFAULT_PROFILE_HINT_ID,
-            resource_values, ARRAY_SIZE(resource_values));
-        ALOGD("%s: set powersave", __func__);
-    }
+/*
+ * 8916 and 8939 share the boost lists and only differ in their profiles.
+ * Either target can still override any of them from the boost config.
+ */
+static const struct resource_list builtin_boost_lists_8916[BOOST_LIST_COUNT] = {
+    [BOOST_LAUNCH] = RESOURCE_LIST(resources_launch),
+    [BOOST_INTERACTION] = RESOURCE_LIST(resources_interaction_boost),
+    [BOOST_INTERACTION_FLING] = RESOURCE_LIST(resources_interaction_fling_boost),
+    [BOOST_CPU_BOOST] = RESOURCE_LIST(resources_cpu_boost),
+    [BOOST_PROFILE_POWER_SAVE] = RESOURCE_LIST(profile_power_save_8916),
+    [BOOST_PROFILE_HIGH_PERFORMANCE] = RESOURCE_LIST(profile_high_performance_8916),
+};
 
-    current_power_profile = profile;
-}
+static const struct resource_list builtin_boost_lists_8939[BOOST_LIST_COUNT] = {
+    [BOOST_LAUNCH] = RESOURCE_LIST(resources_launch),
+    [BOOST_INTERACTION] = RESOURCE_LIST(resources_interaction_boost),
+    [BOOST_INTERACTION_FLING] = RESOURCE_LIST(resources_interaction_fling_boost),
+    [BOOST_CPU_BOOST] = RESOURCE_LIST(resources_cpu_boost),
+    [BOOST_PROFILE_POWER_SAVE] = RESOURCE_LIST(profile_power_save_8939),
+    [BOOST_PROFILE_HIGH_PERFORMANCE] = RESOURCE_LIST(profile_high_performance_8939),
+};
 
-static void process_video_decode_hint(void *metadata)
+static const struct resource_list *builtin_boost_lists(void)
 {
-    char governor[80];
-    struct video_decode_metadata_t video_decode_metadata;
+    return is_target_8916() ? builtin_boost_lists_8916 :
+            builtin_boost_lists_8939;
+}
 
-    if (get_scaling_governor(governor, sizeof(governor)) == -1) {
-        ALOGE("Can't obtain scaling governor.");
+static void set_power_profile(int profile) {
 
+    if (profile == current_power_profile)
         return;
-    }
 
-    if (metadata) {
-        ALOGI("Processing video decode hint. Metadata: %s", (char *)metadata);
-    }
+    ALOGV("%s: profile=%d", __func__, profile);
 
-    /* Initialize encode metadata struct fields. */
-    memset(&video_decode_metadata, 0, sizeof(struct video_decode_metadata_t));
-    video_decode_metadata.state = -1;
-    video_decode_metadata.hint_id = DEFAULT_VIDEO_DECODE_HINT_ID;
+    if (profile == PROFILE_HIGH_PERFORMANCE) {
+        configured_hint_action(BOOST_PROFILE_HIGH_PERFORMANCE,
+                DEFAULT_PROFILE_HINT_ID, builtin_boost_lists());
+        ALOGD("%s: set performance mode", __func__);
 
-    if (metadata) {
-        if (parse_video_decode_metadata((char *)metadata, &video_decode_metadata) ==
-            -1) {
-            ALOGE("Error occurred while parsing metadata.");
-            return;
-        }
-    } else {
-        return;
+    } else if (profile == PROFILE_POWER_SAVE) {
+        configured_hint_action(BOOST_PROFILE_POWER_SAVE,
+                DEFAULT_PROFILE_HINT_ID, builtin_boost_lists());
+        ALOGD("%s: set powersave", __func__);
+    } else if (current_power_profile != PROFILE_BALANCED) {
+        undo_hint_action(DEFAULT_PROFILE_HINT_ID);
+        ALOGV("%s: hint undone", __func__);
     }
 
-    if (video_decode_metadata.state == 1) {
-        if ((strncmp(governor, ONDEMAND_GOVERNOR, strlen(ONDEMAND_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(ONDEMAND_GOVERNOR))) {
-            int resource_values[] = {THREAD_MIGRATION_SYNC_OFF};
-
-            perform_hint_action(video_decode_metadata.hint_id,
-                    resource_values, ARRAY_SIZE(resource_values));
-        } else if ((strncmp(governor, INTERACTIVE_GOVERNOR, strlen(INTERACTIVE_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(INTERACTIVE_GOVERNOR))) {
-            int resource_values[] = {TR_MS_30, HISPEED_LOAD_90, HS_FREQ_1026};
-
-            perform_hint_action(video_decode_metadata.hint_id,
-                    resource_values, ARRAY_SIZE(resource_values));
-        }
-    } else if (video_decode_metadata.state == 0) {
-        if ((strncmp(governor, ONDEMAND_GOVERNOR, strlen(ONDEMAND_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(ONDEMAND_GOVERNOR))) {
-        } else if ((strncmp(governor, INTERACTIVE_GOVERNOR, strlen(INTERACTIVE_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(INTERACTIVE_GOVERNOR))) {
-            undo_hint_action(video_decode_metadata.hint_id);
-        }
-    }
+    current_power_profile = profile;
 }
 
-static void process_video_encode_hint(void *metadata)
-{
-    char governor[80];
-    struct video_encode_metadata_t video_encode_metadata;
-
-    if (get_scaling_governor(governor, sizeof(governor)) == -1) {
-        ALOGE("Can't obtain scaling governor.");
-
-        return;
-    }
-
-    /* Initialize encode metadata struct fields. */
-    memset(&video_encode_metadata, 0, sizeof(struct video_encode_metadata_t));
-    video_encode_metadata.state = -1;
-    video_encode_metadata.hint_id = DEFAULT_VIDEO_ENCODE_HINT_ID;
+static const int video_encode_ondemand[] = {
+    IO_BUSY_OFF, SAMPLING_DOWN_FACTOR_1, THREAD_MIGRATION_SYNC_OFF,
+};
 
-    if (metadata) {
-        if (parse_video_encode_metadata((char *)metadata, &video_encode_metadata) ==
-            -1) {
-            ALOGE("Error occurred while parsing metadata.");
-            return;
-        }
-    } else {
-        return;
-    }
+static const int video_encode_interactive[] = {
+    HS_FREQ_800, 0x1C00,
+};
 
-    if (video_encode_metadata.state == 1) {
-        if ((strncmp(governor, ONDEMAND_GOVERNOR, strlen(ONDEMAND_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(ONDEMAND_GOVERNOR))) {
-            int resource_values[] = {IO_BUSY_OFF, SAMPLING_DOWN_FACTOR_1, THREAD_MIGRATION_SYNC_OFF};
+static const int video_decode_ondemand[] = {
+    THREAD_MIGRATION_SYNC_OFF,
+};
 
-            perform_hint_action(video_encode_metadata.hint_id,
-                resource_values, ARRAY_SIZE(resource_values));
-        } else if ((strncmp(governor, INTERACTIVE_GOVERNOR, strlen(INTERACTIVE_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(INTERACTIVE_GOVERNOR))) {
-            int resource_values[] = {HS_FREQ_800, 0x1C00};
+static const int video_decode_interactive[] = {
+    TR_MS_30, HISPEED_LOAD_90, HS_FREQ_1026,
+};
 
-            perform_hint_action(video_encode_metadata.hint_id,
-                    resource_values, ARRAY_SIZE(resource_values));
-        }
-    } else if (video_encode_metadata.state == 0) {
-        if ((strncmp(governor, ONDEMAND_GOVERNOR, strlen(ONDEMAND_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(ONDEMAND_GOVERNOR))) {
-            undo_hint_action(video_encode_metadata.hint_id);
-        } else if ((strncmp(governor, INTERACTIVE_GOVERNOR, strlen(INTERACTIVE_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(INTERACTIVE_GOVERNOR))) {
-            undo_hint_action(video_encode_metadata.hint_id);
-        }
-    }
-}
+static const struct video_hint_resources video_hint_table[] = {
+    VIDEO_HINT_RESOURCES(POWER_HINT_VIDEO_ENCODE, GOVERNOR_ONDEMAND,
+            video_encode_ondemand),
+    VIDEO_HINT_RESOURCES(POWER_HINT_VIDEO_ENCODE, GOVERNOR_INTERACTIVE,
+            video_encode_interactive),
+    VIDEO_HINT_RESOURCES(POWER_HINT_VIDEO_DECODE, GOVERNOR_ONDEMAND,
+            video_decode_ondemand),
+    VIDEO_HINT_RESOURCES(POWER_HINT_VIDEO_DECODE, GOVERNOR_INTERACTIVE,
+            video_decode_interactive),
+};
 
-extern void interaction(int duration, int num_args, int opt_list[]);
+extern void interaction(int duration, int num_args, const int opt_list[]);
 
 #ifdef __LP64__
 typedef int64_t hintdata;
@@ -256,23 +213,24 @@ typedef int64_t hintdata;
 typedef int hintdata;
 #endif
 
+static const int display_off_8916[] = {
+    TR_MS_50, THREAD_MIGRATION_SYNC_OFF,
+};
+
+static const int display_off_8939[] = {
+    TR_MS_CPU0_50, TR_MS_CPU4_50, THREAD_MIGRATION_SYNC_OFF,
+};
+
 int  set_interactive_override(struct power_module *module __unused, int on)
 {
     char governor[80];
     char tmp_str[NODE_MAX];
     struct video_encode_metadata_t video_encode_metadata;
-    int rc;
 
     ALOGI("Got set_interactive hint");
-    if (get_scaling_governor_check_cores(governor, sizeof(governor),CPU0) == -1) {
-        if (get_scaling_governor_check_cores(governor, sizeof(governor),CPU1) == -1) {
-            if (get_scaling_governor_check_cores(governor, sizeof(governor),CPU2) == -1) {
-                if (get_scaling_governor_check_cores(governor, sizeof(governor),CPU3) == -1) {
-                    ALOGE("Can't obtain scaling governor.");
-                    return HINT_HANDLED;
-                }
-            }
-        }
+    if (get_cluster_scaling_governor(0, governor, sizeof(governor)) == -1) {
+        ALOGE("Can't obtain scaling governor.");
+        return HINT_HANDLED;
     }
 
     if (!on) {
@@ -280,34 +238,20 @@ int  set_interactive_override(struct power_module *module __unused, int on)
         if (is_target_8916()) {
             if ((strncmp(governor, INTERACTIVE_GOVERNOR, strlen(INTERACTIVE_GOVERNOR)) == 0) &&
                 (strlen(governor) == strlen(INTERACTIVE_GOVERNOR))) {
-                int resource_values[] = {TR_MS_50, THREAD_MIGRATION_SYNC_OFF};
                 perform_hint_action(DISPLAY_STATE_HINT_ID,
-                        resource_values, ARRAY_SIZE(resource_values));
+                        display_off_8916, ARRAY_SIZE(display_off_8916));
             } /* Perf time rate set for 8916 target*/
         /* End of display hint for 8916 */
         } else {
              if ((strncmp(governor, INTERACTIVE_GOVERNOR, strlen(INTERACTIVE_GOVERNOR)) == 0) &&
                 (strlen(governor) == strlen(INTERACTIVE_GOVERNOR))) {
-               int resource_values[] = {TR_MS_CPU0_50,TR_MS_CPU4_50, THREAD_MIGRATION_SYNC_OFF};
-
                /* Set CPU0 MIN FREQ to 400Mhz avoid extra peak power
                   impact in volume key press  */
                snprintf(tmp_str, NODE_MAX, "%d", MIN_FREQ_CPU0_DISP_OFF);
-               if (sysfs_write(scaling_min_freq[0], tmp_str) != 0) {
-                   if (sysfs_write(scaling_min_freq[1], tmp_str) != 0) {
-                       if (sysfs_write(scaling_min_freq[2], tmp_str) != 0) {
-                           if (sysfs_write(scaling_min_freq[3], tmp_str) != 0) {
-                               if(!slack_node_rw_failed) {
-                                  ALOGE("Failed to write to %s",SCALING_MIN_FREQ );
-                               }
-                                rc = 1;
-                           }
-                       }
-                   }
-                }
+               cluster_sysfs_write(0, "scaling_min_freq", tmp_str);
 
                 perform_hint_action(DISPLAY_STATE_HINT_ID,
-                        resource_values, ARRAY_SIZE(resource_values));
+                        display_off_8939, ARRAY_SIZE(display_off_8939));
              } /* Perf time rate set for CORE0,CORE4 8939 target*/
         /* End of display hint for 8939 */
         }
@@ -326,18 +270,7 @@ int  set_interactive_override(struct power_module *module __unused, int on)
 
               /* Recovering MIN_FREQ in display ON case */
                snprintf(tmp_str, NODE_MAX, "%d", MIN_FREQ_CPU0_DISP_ON);
-               if (sysfs_write(scaling_min_freq[0], tmp_str) != 0) {
-                   if (sysfs_write(scaling_min_freq[1], tmp_str) != 0) {
-                       if (sysfs_write(scaling_min_freq[2], tmp_str) != 0) {
-                           if (sysfs_write(scaling_min_freq[3], tmp_str) != 0) {
-                               if(!slack_node_rw_failed) {
-                                  ALOGE("Failed to write to %s",SCALING_MIN_FREQ );
-                               }
-                                rc = 1;
-                           }
-                       }
-                   }
-                }
+               cluster_sysfs_write(0, "scaling_min_freq", tmp_str);
              undo_hint_action(DISPLAY_STATE_HINT_ID);
           }
 
@@ -359,9 +292,6 @@ int power_hint_override(struct power_module *module __unused, power_hint_t hint,
 
     if (hint == POWER_HINT_INTERACTION) {
         int duration = 500, duration_hint = 0;
-        static struct timespec s_previous_boost_timespec;
-        struct timespec cur_boost_timespec;
-        long long elapsed_time;
 
         if (data) {
             duration_hint = *((int *)data);
@@ -369,77 +299,40 @@ int power_hint_override(struct power_module *module __unused, power_hint_t hint,
 
         duration = duration_hint > 0 ? duration_hint : 500;
 
-        clock_gettime(CLOCK_MONOTONIC, &cur_boost_timespec);
-        elapsed_time = calc_timespan_us(s_previous_boost_timespec, cur_boost_timespec);
-        if (elapsed_time > 750000)
-            elapsed_time = 750000;
-        // don't hint if it's been less than 250ms since last boost
-        // also detect if we're doing anything resembling a fling
-        // support additional boosting in case of flings
-        else if (elapsed_time < 250000 && duration <= 750)
+        if (!(duration = adjust_interaction_duration(duration)))
             return HINT_HANDLED;
 
-        s_previous_boost_timespec = cur_boost_timespec;
-
         if (duration >= 1500) {
-            int resources[] = {
-                ALL_CPUS_PWR_CLPS_DIS,
-                SCHED_BOOST_ON,
-                SCHED_PREFER_IDLE_DIS,
-                0x20D
-            };
-            interaction(duration, ARRAY_SIZE(resources), resources);
+            configured_interaction(BOOST_INTERACTION_FLING, duration,
+                    builtin_boost_lists());
         } else {
-            int resources[] = {
-                ALL_CPUS_PWR_CLPS_DIS,
-                SCHED_PREFER_IDLE_DIS,
-                0x20D
-            };
-            interaction(duration, ARRAY_SIZE(resources), resources);
+            configured_interaction(BOOST_INTERACTION, duration,
+                    builtin_boost_lists());
         }
         return HINT_HANDLED;
     }
 
     if (hint == POWER_HINT_LAUNCH) {
         int duration = 2000;
-        int resources[] = {
-            ALL_CPUS_PWR_CLPS_DIS,
-            SCHED_BOOST_ON,
-            SCHED_PREFER_IDLE_DIS,
-            0x20F,
-            0x1C00,
-            0x4001,
-            0x4101,
-            0x4201
-        };
-
-        interaction(duration, ARRAY_SIZE(resources), resources);
+
+        configured_interaction(BOOST_LAUNCH, duration, builtin_boost_lists());
 
         return HINT_HANDLED;
 	}
 
     if (hint == POWER_HINT_CPU_BOOST) {
         int duration = *(int32_t *)data / 1000;
-        int resources[] = {
-            ALL_CPUS_PWR_CLPS_DIS,
-            SCHED_BOOST_ON,
-            SCHED_PREFER_IDLE_DIS,
-            0x20D
-        };
 
         if (duration > 0)
-            interaction(duration, ARRAY_SIZE(resources), resources);
+            configured_interaction(BOOST_CPU_BOOST, duration,
+                    builtin_boost_lists());
 
         return HINT_HANDLED;
 	}
 
-    if (hint == POWER_HINT_VIDEO_ENCODE) {
-        process_video_encode_hint(data);
-        return HINT_HANDLED;
-    }
-
-    if (hint == POWER_HINT_VIDEO_DECODE) {
-        process_video_decode_hint(data);
+    if (hint == POWER_HINT_VIDEO_ENCODE || hint == POWER_HINT_VIDEO_DECODE) {
+        process_video_hint(hint, data, video_hint_table,
+                ARRAY_SIZE(video_hint_table));
         return HINT_HANDLED;
     }
 
@@ -36,6 +36,7 @@
 #include <fcntl.h>
 #include <dlfcn.h>
 #include <stdlib.h>
+#include <stdatomic.h>
 
 #define LOG_TAG "QTI PowerHAL"
 #include <utils/Log.h>
@@ -47,15 +48,14 @@
 #include "hint-data.h"
 #include "performance.h"
 #include "power-common.h"
+#include "boost-config.h"
+#include "video-hint.h"
 
-static int video_encode_hint_sent;
-static int current_power_profile = PROFILE_BALANCED;
+static atomic_int current_power_profile = PROFILE_BALANCED;
 
-static void process_video_encode_hint(void *metadata);
+extern void interaction(int duration, int num_args, const int opt_list[]);
 
-extern void interaction(int duration, int num_args, int opt_list[]);
-
-static int profile_high_performance[] = {
+static const int profile_high_performance[] = {
     SCHED_BOOST_ON_V3, 0x1,
     ALL_CPUS_PWR_CLPS_DIS_V3, 0x1,
     CPUS_ONLINE_MIN_BIG, 0x4,
@@ -68,18 +68,18 @@ static int profile_high_performance[] = {
     SCHED_IDLE_LOAD_DIS, 0x1,
 };
 
-static int profile_power_save[] = {
+static const int profile_power_save[] = {
     CPUS_ONLINE_MAX_LIMIT_BIG, 0x1,
     MAX_FREQ_BIG_CORE_0, 0x3bf,
     MAX_FREQ_LITTLE_CORE_0, 0x300,
 };
 
-static int profile_bias_power[] = {
+static const int profile_bias_power[] = {
     MAX_FREQ_BIG_CORE_0, 0x4B0,
     MAX_FREQ_LITTLE_CORE_0, 0x300,
 };
 
-static int profile_bias_performance[] = {
+static const int profile_bias_performance[] = {
     CPUS_ONLINE_MAX_LIMIT_BIG, 0x4,
     MIN_FREQ_BIG_CORE_0, 0x540,
 };
@@ -88,6 +88,86 @@ int get_number_of_profiles() {
     return 5;
 }
 
+static const int resources_launch[] = {
+    SCHED_BOOST_ON_V3, 0x1,
+    MIN_FREQ_BIG_CORE_0, 0x5DC,
+    ALL_CPUS_PWR_CLPS_DIS_V3, 0x1,
+    CPUS_ONLINE_MIN_BIG, 0x4,
+    GPU_MIN_PWRLVL_BOOST, 0x1,
+    SCHED_PREFER_IDLE_DIS_V3, 0x1,
+    SCHED_SMALL_TASK_DIS, 0x1,
+    SCHED_IDLE_NR_RUN_DIS, 0x1,
+    SCHED_IDLE_LOAD_DIS, 0x1,
+};
+
+static const int resources_cpu_boost[] = {
+    SCHED_BOOST_ON_V3, 0x1,
+    MIN_FREQ_BIG_CORE_0, 0x44C,
+};
+
+static const int resources_interaction_fling_boost[] = {
+    MIN_FREQ_BIG_CORE_0, 0x514,
+    SCHED_BOOST_ON_V3, 0x1,
+};
+
+static const struct resource_list builtin_boost_lists[BOOST_LIST_COUNT] = {
+    [BOOST_LAUNCH] = RESOURCE_LIST(resources_launch),
+    [BOOST_INTERACTION_FLING] = RESOURCE_LIST(resources_interaction_fling_boost),
+    [BOOST_CPU_BOOST] = RESOURCE_LIST(resources_cpu_boost),
+    [BOOST_PROFILE_POWER_SAVE] = RESOURCE_LIST(profile_power_save),
+    [BOOST_PROFILE_HIGH_PERFORMANCE] = RESOURCE_LIST(profile_high_performance),
+    [BOOST_PROFILE_BIAS_POWER] = RESOURCE_LIST(profile_bias_power),
+    [BOOST_PROFILE_BIAS_PERFORMANCE] = RESOURCE_LIST(profile_bias_performance),
+};
+
+static const int video_encode_interactive[] = {
+    USE_SCHED_LOAD_BIG, 0x1,
+    USE_SCHED_LOAD_LITTLE, 0x1,
+    USE_MIGRATION_NOTIF_BIG, 0x1,
+    USE_MIGRATION_NOTIF_LITTLE, 0x1,
+    TIMER_RATE_BIG, 0x28,
+    TIMER_RATE_LITTLE, 0x28,
+};
+
+static const struct video_hint_resources video_hint_table[] = {
+    VIDEO_HINT_RESOURCES(POWER_HINT_VIDEO_ENCODE, GOVERNOR_INTERACTIVE,
+            video_encode_interactive),
+};
+
+/*
+ * Camera preview: cap the little cluster, move bus DCVS to its low power
+ * config and stop storage clock scaling.
+ */
+static const int cam_preview_resources[] = {
+    MAX_FREQ_LITTLE_CORE_0, 0x3C0,
+    LOW_POWER_CEIL_MBPS, 0x9C4,
+    LOW_POWER_IO_PERCENT, 0x32,
+    STOR_CLK_SCALE_DIS, 0x1,
+};
+
+static const struct resource_list cam_preview_list =
+        RESOURCE_LIST(cam_preview_resources);
+
+const struct resource_list *get_cam_preview_resources(void)
+{
+    return &cam_preview_list;
+}
+
+/*
+ * Low-latency audio: a little cluster floor, so the audio thread doesn't
+ * run at the lowest frequency between bursts.
+ */
+static const int audio_resources[] = {
+    MIN_FREQ_LITTLE_CORE_0, 0x300,
+};
+
+static const struct resource_list audio_list = RESOURCE_LIST(audio_resources);
+
+const struct resource_list *get_audio_resources(void)
+{
+    return &audio_list;
+}
+
 static void set_power_profile(int profile) {
 
     if (profile == current_power_profile)
@@ -95,29 +175,27 @@ static void set_power_profile(int profile) {
 
     ALOGV("%s: profile=%d", __func__, profile);
 
-    if (current_power_profile != PROFILE_BALANCED) {
-        undo_hint_action(DEFAULT_PROFILE_HINT_ID);
-        ALOGV("%s: hint undone", __func__);
-    }
-
     if (profile == PROFILE_HIGH_PERFORMANCE) {
-        perform_hint_action(DEFAULT_PROFILE_HINT_ID, profile_high_performance,
-                ARRAY_SIZE(profile_high_performance));
+        configured_hint_action(BOOST_PROFILE_HIGH_PERFORMANCE,
+                DEFAULT_PROFILE_HINT_ID, builtin_boost_lists);
         ALOGD("%s: set performance mode", __func__);
 
     } else if (profile == PROFILE_POWER_SAVE) {
-        perform_hint_action(DEFAULT_PROFILE_HINT_ID, profile_power_save,
-                ARRAY_SIZE(profile_power_save));
+        configured_hint_action(BOOST_PROFILE_POWER_SAVE,
+                DEFAULT_PROFILE_HINT_ID, builtin_boost_lists);
         ALOGD("%s: set powersave", __func__);
     } else if (profile == PROFILE_BIAS_POWER) {
-        perform_hint_action(DEFAULT_PROFILE_HINT_ID, profile_bias_power,
-                ARRAY_SIZE(profile_bias_power));
+        configured_hint_action(BOOST_PROFILE_BIAS_POWER,
+                DEFAULT_PROFILE_HINT_ID, builtin_boost_lists);
         ALOGD("%s: Set bias power mode", __func__);
 
     } else if (profile == PROFILE_BIAS_PERFORMANCE) {
-        perform_hint_action(DEFAULT_PROFILE_HINT_ID, profile_bias_performance,
-                ARRAY_SIZE(profile_bias_performance));
+        configured_hint_action(BOOST_PROFILE_BIAS_PERFORMANCE,
+                DEFAULT_PROFILE_HINT_ID, builtin_boost_lists);
         ALOGD("%s: Set bias perf mode", __func__);
+    } else if (current_power_profile != PROFILE_BALANCED) {
+        undo_hint_action(DEFAULT_PROFILE_HINT_ID);
+        ALOGV("%s: hint undone", __func__);
     }
 
     current_power_profile = profile;
@@ -127,30 +205,6 @@ int power_hint_override(__unused struct power_module *module, power_hint_t hint,
         void *data)
 {
     int duration, duration_hint;
-    static struct timespec s_previous_boost_timespec;
-    struct timespec cur_boost_timespec;
-    long long elapsed_time;
-    int resources_launch[] = {
-        SCHED_BOOST_ON_V3, 0x1,
-        MIN_FREQ_BIG_CORE_0, 0x5DC,
-        ALL_CPUS_PWR_CLPS_DIS_V3, 0x1,
-        CPUS_ONLINE_MIN_BIG, 0x4,
-        GPU_MIN_PWRLVL_BOOST, 0x1,
-        SCHED_PREFER_IDLE_DIS_V3, 0x1,
-        SCHED_SMALL_TASK_DIS, 0x1,
-        SCHED_IDLE_NR_RUN_DIS, 0x1,
-        SCHED_IDLE_LOAD_DIS, 0x1,
-    };
-
-    int resources_cpu_boost[] = {
-        SCHED_BOOST_ON_V3, 0x1,
-        MIN_FREQ_BIG_CORE_0, 0x44C,
-    };
-
-    int resources_interaction_fling_boost[] = {
-        MIN_FREQ_BIG_CORE_0, 0x514,
-        SCHED_BOOST_ON_V3, 0x1,
-    };
 
     if (hint == POWER_HINT_SET_PROFILE) {
         set_power_profile(*(int32_t *)data);
@@ -173,37 +227,28 @@ int power_hint_override(__unused struct power_module *module, power_hint_t hint,
 
             duration = duration_hint > 0 ? duration_hint : 500;
 
-            clock_gettime(CLOCK_MONOTONIC, &cur_boost_timespec);
-            elapsed_time = calc_timespan_us(s_previous_boost_timespec, cur_boost_timespec);
-            if (elapsed_time > 750000)
-                elapsed_time = 750000;
-            // don't hint if it's been less than 250ms since last boost
-            // also detect if we're doing anything resembling a fling
-            // support additional boosting in case of flings
-            else if (elapsed_time < 250000 && duration <= 750)
+            if (!(duration = adjust_interaction_duration(duration)))
                 return HINT_HANDLED;
 
-            s_previous_boost_timespec = cur_boost_timespec;
-
             if (duration >= 1500) {
-                interaction(duration, ARRAY_SIZE(resources_interaction_fling_boost),
-                        resources_interaction_fling_boost);
+                configured_interaction(BOOST_INTERACTION_FLING, duration,
+                        builtin_boost_lists);
             }
             return HINT_HANDLED;
         case POWER_HINT_LAUNCH:
             duration = 2000;
-            interaction(duration, ARRAY_SIZE(resources_launch),
-                    resources_launch);
+            configured_interaction(BOOST_LAUNCH, duration, builtin_boost_lists);
             return HINT_HANDLED;
         case POWER_HINT_CPU_BOOST:
             duration = *(int32_t *)data / 1000;
             if (duration > 0) {
-                interaction(duration, ARRAY_SIZE(resources_cpu_boost),
-                        resources_cpu_boost);
+                configured_interaction(BOOST_CPU_BOOST, duration,
+                        builtin_boost_lists);
             }
             return HINT_HANDLED;
         case POWER_HINT_VIDEO_ENCODE:
-            process_video_encode_hint(data);
+            process_video_hint(hint, data, video_hint_table,
+                    ARRAY_SIZE(video_hint_table));
             return HINT_HANDLED;
         default:
             break;
@@ -211,35 +256,30 @@ int power_hint_override(__unused struct power_module *module, power_hint_t hint,
     return HINT_NONE;
 }
 
+static const int display_off_interactive_resources[] = {
+    TIMER_RATE_BIG, 0x32,
+    TIMER_RATE_LITTLE, 0x32,
+    THREAD_MIGRATION_SYNC_ON_V3, 0x0,
+};
+
 int set_interactive_override(__unused struct power_module *module, int on)
 {
     char governor[80];
 
     ALOGI("Got set_interactive hint");
 
-    if (get_scaling_governor_check_cores(governor, sizeof(governor),CPU0) == -1) {
-        if (get_scaling_governor_check_cores(governor, sizeof(governor),CPU1) == -1) {
-            if (get_scaling_governor_check_cores(governor, sizeof(governor),CPU2) == -1) {
-                if (get_scaling_governor_check_cores(governor, sizeof(governor),CPU3) == -1) {
-                    ALOGE("Can't obtain scaling governor.");
-                    return HINT_HANDLED;
-                }
-            }
-        }
+    if (get_cluster_scaling_governor(0, governor, sizeof(governor)) == -1) {
+        ALOGE("Can't obtain scaling governor.");
+        return HINT_HANDLED;
     }
 
     if (!on) {
         /* Display off. */
              if ((strncmp(governor, INTERACTIVE_GOVERNOR, strlen(INTERACTIVE_GOVERNOR)) == 0) &&
                 (strlen(governor) == strlen(INTERACTIVE_GOVERNOR))) {
-               int resource_values[] = {
-                   TIMER_RATE_BIG, 0x32,
-                   TIMER_RATE_LITTLE, 0x32,
-                   THREAD_MIGRATION_SYNC_ON_V3, 0x0,
-               };
-
                 perform_hint_action(DISPLAY_STATE_HINT_ID,
-                        resource_values, ARRAY_SIZE(resource_values));
+                        display_off_interactive_resources,
+                        ARRAY_SIZE(display_off_interactive_resources));
              } /* Perf time rate set for CORE0,CORE4 8952 target*/
 
     } else {
@@ -252,72 +292,3 @@ int set_interactive_override(__unused struct power_module *module, int on)
    }
     return HINT_HANDLED;
 }
-
-/* Video Encode Hint */
-static void process_video_encode_hint(void *metadata)
-{
-    char governor[80];
-    struct video_encode_metadata_t video_encode_metadata;
-
-    ALOGI("Got process_video_encode_hint");
-
-    if (get_scaling_governor_check_cores(governor,
-        sizeof(governor),CPU0) == -1) {
-            if (get_scaling_governor_check_cores(governor,
-                sizeof(governor),CPU1) == -1) {
-                    if (get_scaling_governor_check_cores(governor,
-                        sizeof(governor),CPU2) == -1) {
-                            if (get_scaling_governor_check_cores(governor,
-                                sizeof(governor),CPU3) == -1) {
-                                    ALOGE("Can't obtain scaling governor.");
-                                    return;
-                            }
-                    }
-            }
-    }
-
-    /* Initialize encode metadata struct fields. */
-    memset(&video_encode_metadata, 0, sizeof(struct video_encode_metadata_t));
-    video_encode_metadata.state = -1;
-    video_encode_metadata.hint_id = DEFAULT_VIDEO_ENCODE_HINT_ID;
-
-    if (metadata) {
-        if (parse_video_encode_metadata((char *)metadata,
-            &video_encode_metadata) == -1) {
-            ALOGE("Error occurred while parsing metadata.");
-            return;
-        }
-    } else {
-        return;
-    }
-
-    if (video_encode_metadata.state == 1) {
-        if ((strncmp(governor, INTERACTIVE_GOVERNOR,
-            strlen(INTERACTIVE_GOVERNOR)) == 0) &&
-            (strlen(governor) == strlen(INTERACTIVE_GOVERNOR))) {
-            int resource_values[] = {
-                USE_SCHED_LOAD_BIG, 0x1,
-                USE_SCHED_LOAD_LITTLE, 0x1,
-                USE_MIGRATION_NOTIF_BIG, 0x1,
-                USE_MIGRATION_NOTIF_LITTLE, 0x1,
-                TIMER_RATE_BIG, 0x28,
-                TIMER_RATE_LITTLE, 0x28,
-            };
-            if (!video_encode_hint_sent) {
-                perform_hint_action(video_encode_metadata.hint_id,
-                resource_values,
-                ARRAY_SIZE(resource_values));
-                video_encode_hint_sent = 1;
-            }
-        }
-    } else if (video_encode_metadata.state == 0) {
-        if ((strncmp(governor, INTERACTIVE_GOVERNOR,
-            strlen(INTERACTIVE_GOVERNOR)) == 0) &&
-            (strlen(governor) == strlen(INTERACTIVE_GOVERNOR))) {
-            undo_hint_action(video_encode_metadata.hint_id);
-            video_encode_hint_sent = 0;
-            return ;
-        }
-    }
-    return;
-}
@@ -36,6 +36,7 @@
 #include <fcntl.h>
 #include <dlfcn.h>
 #include <stdlib.h>
+#include <stdatomic.h>
 
 #define LOG_TAG "QTI PowerHAL"
 #include <utils/Log.h>
@@ -47,15 +48,14 @@
 #include "hint-data.h"
 #include "performance.h"
 #include "power-common.h"
+#include "boost-config.h"
+#include "video-hint.h"
 
-static int video_encode_hint_sent;
-static int current_power_profile = PROFILE_BALANCED;
+static atomic_int current_power_profile = PROFILE_BALANCED;
 
-static void process_video_encode_hint(void *metadata);
+extern void interaction(int duration, int num_args, const int opt_list[]);
 
-extern void interaction(int duration, int num_args, int opt_list[]);
-
-static int profile_high_performance_8952[11] = {
+static const int profile_high_performance_8952[11] = {
     SCHED_BOOST_ON,
     0x704, 0x4d04, /* Enable all CPUs */
     CPU0_MIN_FREQ_TURBO_MAX, CPU1_MIN_FREQ_TURBO_MAX,
@@ -64,7 +64,7 @@ static int profile_high_performance_8952[11] = {
     CPU6_MIN_FREQ_TURBO_MAX, CPU7_MIN_FREQ_TURBO_MAX,
 };
 
-static int profile_power_save_8952[] = {
+static const int profile_power_save_8952[] = {
     0x8fe, 0x3dfd, /* 1 big core, 2 little cores*/
     CPUS_ONLINE_MAX_LIMIT_2,
     CPU0_MAX_FREQ_NONTURBO_MAX, CPU1_MAX_FREQ_NONTURBO_MAX,
@@ -75,6 +75,47 @@ int get_number_of_profiles() {
     return 3;
 }
 
+static const int resources_launch[] = {
+    ALL_CPUS_PWR_CLPS_DIS,
+    SCHED_BOOST_ON,
+    SCHED_PREFER_IDLE_DIS,
+    0x20f,
+    0x4001,
+    0x4101,
+    0x4201,
+};
+
+static const int resources_cpu_boost[] = {
+    ALL_CPUS_PWR_CLPS_DIS,
+    SCHED_BOOST_ON,
+    SCHED_PREFER_IDLE_DIS,
+    0x20d,
+};
+
+static const int resources_interaction_boost[] = {
+    SCHED_PREFER_IDLE_DIS,
+    0x20d,
+    0x3d01,
+};
+
+static const struct resource_list builtin_boost_lists[BOOST_LIST_COUNT] = {
+    [BOOST_LAUNCH] = RESOURCE_LIST(resources_launch),
+    [BOOST_INTERACTION] = RESOURCE_LIST(resources_interaction_boost),
+    [BOOST_INTERACTION_FLING] = RESOURCE_LIST(resources_cpu_boost),
+    [BOOST_CPU_BOOST] = RESOURCE_LIST(resources_cpu_boost),
+    [BOOST_PROFILE_POWER_SAVE] = RESOURCE_LIST(profile_power_save_8952),
+    [BOOST_PROFILE_HIGH_PERFORMANCE] = RESOURCE_LIST(profile_high_performance_8952),
+};
+
+static const int video_encode_interactive[] = {
+    TR_MS_CPU0_30, TR_MS_CPU4_30,
+};
+
+static const struct video_hint_resources video_hint_table[] = {
+    VIDEO_HINT_RESOURCES(POWER_HINT_VIDEO_ENCODE, GOVERNOR_INTERACTIVE,
+            video_encode_interactive),
+};
+
 static void set_power_profile(int profile) {
 
     if (profile == current_power_profile)
@@ -82,22 +123,18 @@ static void set_power_profile(int profile) {
 
     ALOGV("%s: profile=%d", __func__, profile);
 
-    if (current_power_profile != PROFILE_BALANCED) {
-        undo_hint_action(DEFAULT_PROFILE_HINT_ID);
-        ALOGV("%s: hint undone", __func__);
-    }
-
     if (profile == PROFILE_HIGH_PERFORMANCE) {
-        int *resource_values = profile_high_performance_8952;
-        perform_hint_action(DEFAULT_PROFILE_HINT_ID, resource_values,
-                ARRAY_SIZE(resource_values));
+        configured_hint_action(BOOST_PROFILE_HIGH_PERFORMANCE,
+                DEFAULT_PROFILE_HINT_ID, builtin_boost_lists);
         ALOGD("%s: set performance mode", __func__);
 
     } else if (profile == PROFILE_POWER_SAVE) {
-        int *resource_values = profile_power_save_8952;
-        perform_hint_action(DEFAULT_PROFILE_HINT_ID, resource_values,
-                ARRAY_SIZE(resource_values));
+        configured_hint_action(BOOST_PROFILE_POWER_SAVE,
+                DEFAULT_PROFILE_HINT_ID, builtin_boost_lists);
         ALOGD("%s: set powersave", __func__);
+    } else if (current_power_profile != PROFILE_BALANCED) {
+        undo_hint_action(DEFAULT_PROFILE_HINT_ID);
+        ALOGV("%s: hint undone", __func__);
     }
 
     current_power_profile = profile;
@@ -107,29 +144,6 @@ int  power_hint_override(struct power_module *module, power_hint_t hint,
         void *data)
 {
     int duration, duration_hint;
-    static struct timespec s_previous_boost_timespec;
-    struct timespec cur_boost_timespec;
-    long long elapsed_time;
-    int resources_launch[] = {
-        ALL_CPUS_PWR_CLPS_DIS,
-        SCHED_BOOST_ON,
-        SCHED_PREFER_IDLE_DIS,
-        0x20f,
-        0x4001,
-        0x4101,
-        0x4201,
-    };
-    int resources_cpu_boost[] = {
-        ALL_CPUS_PWR_CLPS_DIS,
-        SCHED_BOOST_ON,
-        SCHED_PREFER_IDLE_DIS,
-        0x20d,
-    };
-    int resources_interaction_boost[] = {
-        SCHED_PREFER_IDLE_DIS,
-        0x20d,
-        0x3d01,
-    };
 
     if (hint == POWER_HINT_SET_PROFILE) {
         set_power_profile(*(int32_t *)data);
@@ -152,70 +166,58 @@ int  power_hint_override(struct power_module *module, power_hint_t hint,
 
             duration = duration_hint > 0 ? duration_hint : 500;
 
-            clock_gettime(CLOCK_MONOTONIC, &cur_boost_timespec);
-            elapsed_time = calc_timespan_us(s_previous_boost_timespec, cur_boost_timespec);
-            if (elapsed_time > 750000)
-                elapsed_time = 750000;
-            // don't hint if it's been less than 250ms since last boost
-            // also detect if we're doing anything resembling a fling
-            // support additional boosting in case of flings
-            else if (elapsed_time < 250000 && duration <= 750)
+            if (!(duration = adjust_interaction_duration(duration)))
                 return HINT_HANDLED;
 
-            s_previous_boost_timespec = cur_boost_timespec;
-
             if (duration >= 1500) {
-                interaction(duration, ARRAY_SIZE(resources_cpu_boost),
-                        resources_cpu_boost);
+                configured_interaction(BOOST_INTERACTION_FLING, duration,
+                        builtin_boost_lists);
             } else {
-                interaction(duration, ARRAY_SIZE(resources_interaction_boost),
-                        resources_interaction_boost);
+                configured_interaction(BOOST_INTERACTION, duration,
+                        builtin_boost_lists);
             }
             return HINT_HANDLED;
         case POWER_HINT_LAUNCH:
             duration = 2000;
-            interaction(duration, ARRAY_SIZE(resources_launch),
-                    resources_launch);
+            configured_interaction(BOOST_LAUNCH, duration, builtin_boost_lists);
             return HINT_HANDLED;
         case POWER_HINT_CPU_BOOST:
             duration = *(int32_t *)data / 1000;
             if (duration > 0) {
-                interaction(duration, ARRAY_SIZE(resources_cpu_boost),
-                        resources_cpu_boost);
+                configured_interaction(BOOST_CPU_BOOST, duration,
+                        builtin_boost_lists);
             }
             return HINT_HANDLED;
         case POWER_HINT_VIDEO_ENCODE:
-            process_video_encode_hint(data);
+            process_video_hint(hint, data, video_hint_table,
+                    ARRAY_SIZE(video_hint_table));
             return HINT_HANDLED;
     }
     return HINT_NONE;
 }
 
+static const int display_off_interactive_resources[] = {
+    TR_MS_CPU0_50, TR_MS_CPU4_50,
+};
+
 int  set_interactive_override(struct power_module *module, int on)
 {
     char governor[80];
 
     ALOGI("Got set_interactive hint");
 
-    if (get_scaling_governor_check_cores(governor, sizeof(governor),CPU0) == -1) {
-        if (get_scaling_governor_check_cores(governor, sizeof(governor),CPU1) == -1) {
-            if (get_scaling_governor_check_cores(governor, sizeof(governor),CPU2) == -1) {
-                if (get_scaling_governor_check_cores(governor, sizeof(governor),CPU3) == -1) {
-                    ALOGE("Can't obtain scaling governor.");
-                    return HINT_HANDLED;
-                }
-            }
-        }
+    if (get_cluster_scaling_governor(0, governor, sizeof(governor)) == -1) {
+        ALOGE("Can't obtain scaling governor.");
+        return HINT_HANDLED;
     }
 
     if (!on) {
         /* Display off. */
              if ((strncmp(governor, INTERACTIVE_GOVERNOR, strlen(INTERACTIVE_GOVERNOR)) == 0) &&
                 (strlen(governor) == strlen(INTERACTIVE_GOVERNOR))) {
-               int resource_values[] = {TR_MS_CPU0_50, TR_MS_CPU4_50};
-
                 perform_hint_action(DISPLAY_STATE_HINT_ID,
-                        resource_values, ARRAY_SIZE(resource_values));
+                        display_off_interactive_resources,
+                        ARRAY_SIZE(display_off_interactive_resources));
              } /* Perf time rate set for CORE0,CORE4 8952 target*/
 
     } else {
@@ -228,65 +230,3 @@ int  set_interactive_override(struct power_module *module, int on)
    }
     return HINT_HANDLED;
 }
-
-/* Video Encode Hint */
-static void process_video_encode_hint(void *metadata)
-{
-    char governor[80];
-    struct video_encode_metadata_t video_encode_metadata;
-
-    ALOGI("Got process_video_encode_hint");
-
-    if (get_scaling_governor_check_cores(governor,
-        sizeof(governor),CPU0) == -1) {
-            if (get_scaling_governor_check_cores(governor,
-                sizeof(governor),CPU1) == -1) {
-                    if (get_scaling_governor_check_cores(governor,
-                        sizeof(governor),CPU2) == -1) {
-                            if (get_scaling_governor_check_cores(governor,
-                                sizeof(governor),CPU3) == -1) {
-                                    ALOGE("Can't obtain scaling governor.");
-                                    return;
-                            }
-                    }
-            }
-    }
-
-    /* Initialize encode metadata struct fields. */
-    memset(&video_encode_metadata, 0, sizeof(struct video_encode_metadata_t));
-    video_encode_metadata.state = -1;
-    video_encode_metadata.hint_id = DEFAULT_VIDEO_ENCODE_HINT_ID;
-
-    if (metadata) {
-        if (parse_video_encode_metadata((char *)metadata,
-            &video_encode_metadata) == -1) {
-            ALOGE("Error occurred while parsing metadata.");
-            return;
-        }
-    } else {
-        return;
-    }
-
-    if (video_encode_metadata.state == 1) {
-        if ((strncmp(governor, INTERACTIVE_GOVERNOR,
-            strlen(INTERACTIVE_GOVERNOR)) == 0) &&
-            (strlen(governor) == strlen(INTERACTIVE_GOVERNOR))) {
-            int resource_values[] = {TR_MS_CPU0_30, TR_MS_CPU4_30};
-            if (!video_encode_hint_sent) {
-                perform_hint_action(video_encode_metadata.hint_id,
-                resource_values,
-                ARRAY_SIZE(resource_values));
-                video_encode_hint_sent = 1;
-            }
-        }
-    } else if (video_encode_metadata.state == 0) {
-        if ((strncmp(governor, INTERACTIVE_GOVERNOR,
-            strlen(INTERACTIVE_GOVERNOR)) == 0) &&
-            (strlen(governor) == strlen(INTERACTIVE_GOVERNOR))) {
-            undo_hint_action(video_encode_metadata.hint_id);
-            video_encode_hint_sent = 0;
-            return ;
-        }
-    }
-    return;
-}
@@ -36,6 +36,7 @@
 #include <fcntl.h>
 #include <dlfcn.h>
 #include <stdlib.h>
+#include <stdatomic.h>
 
 #define LOG_TAG "QCOM PowerHAL"
 #include <utils/Log.h>
@@ -47,8 +48,9 @@
 #include "hint-data.h"
 #include "performance.h"
 #include "power-common.h"
+#include "boost-config.h"
 
-static int current_power_profile = PROFILE_BALANCED;
+static atomic_int current_power_profile = PROFILE_BALANCED;
 
 int get_number_of_profiles() {
     return 3;
@@ -62,37 +64,43 @@ int get_number_of_profiles() {
  */
 static int is_target_8064(void)
 {
-    static int is_8064 = -1;
-    int soc_id;
+    int soc_id = get_soc_id();
 
-    if (is_8064 >= 0)
-        return is_8064;
-
-    soc_id = get_soc_id();
-    if (soc_id == 153)
-        is_8064 = 1;
-    else
-        is_8064 = 0;
-
-    return is_8064;
+    return soc_id == 153;
 }
 
-static int profile_high_performance_8960[] = {
+static const int profile_high_performance_8960[] = {
     CPUS_ONLINE_MIN_2,
 };
 
-static int profile_high_performance_8064[] = {
+static const int profile_high_performance_8064[] = {
     CPUS_ONLINE_MIN_4,
 };
 
-static int profile_power_save_8960[] = {
+static const int profile_power_save_8960[] = {
     /* Don't do anything for now */
 };
 
-static int profile_power_save_8064[] = {
+static const int profile_power_save_8064[] = {
     CPUS_ONLINE_MAX_LIMIT_2,
 };
 
+static const struct resource_list builtin_boost_lists_8960[BOOST_LIST_COUNT] = {
+    [BOOST_PROFILE_POWER_SAVE] = RESOURCE_LIST(profile_power_save_8960),
+    [BOOST_PROFILE_HIGH_PERFORMANCE] = RESOURCE_LIST(profile_high_performance_8960),
+};
+
+static const struct resource_list builtin_boost_lists_8064[BOOST_LIST_COUNT] = {
+    [BOOST_PROFILE_POWER_SAVE] = RESOURCE_LIST(profile_power_save_8064),
+    [BOOST_PROFILE_HIGH_PERFORMANCE] = RESOURCE_LIST(profile_high_performance_8064),
+};
+
+static const struct resource_list *builtin_boost_lists(void)
+{
+    return is_target_8064() ? builtin_boost_lists_8064 :
+            builtin_boost_lists_8960;
+}
+
 static void set_power_profile(int profile) {
 
     if (profile == current_power_profile)
@@ -100,25 +108,17 @@ static void set_power_profile(int profile) {
 
     ALOGV("%s: profile=%d", __func__, profile);
 
-    if (current_power_profile != PROFILE_BALANCED) {
-        undo_hint_action(DEFAULT_PROFILE_HINT_ID);
-        ALOGV("%s: hint undone", __func__);
-    }
-
     if (profile == PROFILE_HIGH_PERFORMANCE) {
-        int *resource_values = is_target_8064() ?
-            profile_high_performance_8064 : profile_high_performance_8960;
-
-        perform_hint_action(DEFAULT_PROFILE_HINT_ID,
-            resource_values, ARRAY_SIZE(resource_values));
+        configured_hint_action(BOOST_PROFILE_HIGH_PERFORMANCE,
+                DEFAULT_PROFILE_HINT_ID, builtin_boost_lists());
         ALOGD("%s: set performance mode", __func__);
     } else if (profile == PROFILE_POWER_SAVE) {
-        int* resource_values = is_target_8064() ?
-            profile_power_save_8064 : profile_power_save_8960;
-
-        perform_hint_action(DEFAULT_PROFILE_HINT_ID,
-            resource_values, ARRAY_SIZE(resource_values));
+        configured_hint_action(BOOST_PROFILE_POWER_SAVE,
+                DEFAULT_PROFILE_HINT_ID, builtin_boost_lists());
         ALOGD("%s: set powersave", __func__);
+    } else if (current_power_profile != PROFILE_BALANCED) {
+        undo_hint_action(DEFAULT_PROFILE_HINT_ID);
+        ALOGV("%s: hint undone", __func__);
     }
 
     current_power_profile = profile;
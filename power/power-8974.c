@@ -36,6 +36,7 @@
 #include <fcntl.h>
 #include <dlfcn.h>
 #include <stdlib.h>
+#include <stdatomic.h>
 
 #define LOG_TAG "QCOM PowerHAL"
 #include <utils/Log.h>
@@ -47,10 +48,11 @@
 #include "hint-data.h"
 #include "performance.h"
 #include "power-common.h"
+#include "boost-config.h"
 
 static int first_display_off_hint;
 
-static int current_power_profile = PROFILE_BALANCED;
+static atomic_int current_power_profile = PROFILE_BALANCED;
 
 int get_number_of_profiles() {
     return 5;
@@ -64,21 +66,66 @@ int get_number_of_profiles() {
  */
 static int is_target_8974pro(void)
 {
-    static int is_8974pro = -1;
-    int soc_id;
+    int soc_id = get_soc_id();
 
-    if (is_8974pro >= 0)
-        return is_8974pro;
-
-    soc_id = get_soc_id();
-    if (soc_id == 194 || (soc_id >= 208 && soc_id <= 218))
-        is_8974pro = 1;
-    else
-        is_8974pro = 0;
-
-    return is_8974pro;
+    return soc_id == 194 || (soc_id >= 208 && soc_id <= 218);
 }
 
+static const int profile_high_performance[] = {
+    CPUS_ONLINE_MIN_4, 0x0901,
+    CPU0_MIN_FREQ_TURBO_MAX, CPU1_MIN_FREQ_TURBO_MAX,
+    CPU2_MIN_FREQ_TURBO_MAX, CPU3_MIN_FREQ_TURBO_MAX,
+};
+
+static const int profile_bias_performance[] = {
+    CPU0_MIN_FREQ_NONTURBO_MAX + 1, CPU1_MIN_FREQ_NONTURBO_MAX + 1,
+    CPU2_MIN_FREQ_NONTURBO_MAX + 1, CPU2_MIN_FREQ_NONTURBO_MAX + 1,
+};
+
+static const int profile_bias_power[] = {
+    0x0A03,
+    CPU0_MAX_FREQ_NONTURBO_MAX, CPU1_MAX_FREQ_NONTURBO_MAX,
+    CPU1_MAX_FREQ_NONTURBO_MAX, CPU2_MAX_FREQ_NONTURBO_MAX,
+};
+
+static const int profile_power_save[] = {
+    0x0A03, CPUS_ONLINE_MAX_LIMIT_2,
+    CPU0_MAX_FREQ_NONTURBO_MAX, CPU1_MAX_FREQ_NONTURBO_MAX,
+    CPU2_MAX_FREQ_NONTURBO_MAX, CPU3_MAX_FREQ_NONTURBO_MAX,
+};
+
+static const int resources_launch[] = {
+    CPUS_ONLINE_MIN_3,
+    CPU0_MIN_FREQ_TURBO_MAX, CPU1_MIN_FREQ_TURBO_MAX,
+    CPU2_MIN_FREQ_TURBO_MAX, CPU3_MIN_FREQ_TURBO_MAX,
+};
+
+static const int resources_cpu_boost[] = {
+    CPUS_ONLINE_MIN_2,
+    0x20F, 0x30F, 0x40F, 0x50F,
+};
+
+static const int resources_interaction_fling_boost[] = {
+    CPUS_ONLINE_MIN_3,
+    0x20F, 0x30F, 0x40F, 0x50F,
+};
+
+static const int resources_interaction_boost[] = {
+    CPUS_ONLINE_MIN_2,
+    0x20F, 0x30F, 0x40F, 0x50F,
+};
+
+static const struct resource_list builtin_boost_lists[BOOST_LIST_COUNT] = {
+    [BOOST_LAUNCH] = RESOURCE_LIST(resources_launch),
+    [BOOST_INTERACTION] = RESOURCE_LIST(resources_interaction_boost),
+    [BOOST_INTERACTION_FLING] = RESOURCE_LIST(resources_interaction_fling_boost),
+    [BOOST_CPU_BOOST] = RESOURCE_LIST(resources_cpu_boost),
+    [BOOST_PROFILE_POWER_SAVE] = RESOURCE_LIST(profile_power_save),
+    [BOOST_PROFILE_HIGH_PERFORMANCE] = RESOURCE_LIST(profile_high_performance),
+    [BOOST_PROFILE_BIAS_POWER] = RESOURCE_LIST(profile_bias_power),
+    [BOOST_PROFILE_BIAS_PERFORMANCE] = RESOURCE_LIST(profile_bias_performance),
+};
+
 static void set_power_profile(int profile) {
 
     if (profile == current_power_profile)
@@ -86,45 +133,31 @@ static void set_power_profile(int profile) {
 
     ALOGV("%s: profile=%d", __func__, profile);
 
-    if (current_power_profile != PROFILE_BALANCED) {
-        undo_hint_action(DEFAULT_PROFILE_HINT_ID);
-        ALOGV("%s: hint undone", __func__);
-    }
-
     if (profile == PROFILE_HIGH_PERFORMANCE) {
-        int resource_values[] = { CPUS_ONLINE_MIN_4, 0x0901,
-            CPU0_MIN_FREQ_TURBO_MAX, CPU1_MIN_FREQ_TURBO_MAX,
-            CPU2_MIN_FREQ_TURBO_MAX, CPU3_MIN_FREQ_TURBO_MAX };
-        perform_hint_action(DEFAULT_PROFILE_HINT_ID,
-            resource_values, ARRAY_SIZE(resource_values));
+        configured_hint_action(BOOST_PROFILE_HIGH_PERFORMANCE,
+                DEFAULT_PROFILE_HINT_ID, builtin_boost_lists);
         ALOGD("%s: set performance mode", __func__);
     } else if (profile == PROFILE_BIAS_PERFORMANCE) {
-        int resource_values[] = {
-            CPU0_MIN_FREQ_NONTURBO_MAX + 1, CPU1_MIN_FREQ_NONTURBO_MAX + 1,
-            CPU2_MIN_FREQ_NONTURBO_MAX + 1, CPU2_MIN_FREQ_NONTURBO_MAX + 1 };
-        perform_hint_action(DEFAULT_PROFILE_HINT_ID,
-            resource_values, ARRAY_SIZE(resource_values));
+        configured_hint_action(BOOST_PROFILE_BIAS_PERFORMANCE,
+                DEFAULT_PROFILE_HINT_ID, builtin_boost_lists);
         ALOGD("%s: set bias perf mode", __func__);
     } else if (profile == PROFILE_BIAS_POWER) {
-        int resource_values[] = { 0x0A03,
-            CPU0_MAX_FREQ_NONTURBO_MAX, CPU1_MAX_FREQ_NONTURBO_MAX,
-            CPU1_MAX_FREQ_NONTURBO_MAX, CPU2_MAX_FREQ_NONTURBO_MAX };
-        perform_hint_action(DEFAULT_PROFILE_HINT_ID,
-            resource_values, ARRAY_SIZE(resource_values));
+        configured_hint_action(BOOST_PROFILE_BIAS_POWER,
+                DEFAULT_PROFILE_HINT_ID, builtin_boost_lists);
         ALOGD("%s: set bias power mode", __func__);
     } else if (profile == PROFILE_POWER_SAVE) {
-        int resource_values[] = { 0x0A03, CPUS_ONLINE_MAX_LIMIT_2,
-            CPU0_MAX_FREQ_NONTURBO_MAX, CPU1_MAX_FREQ_NONTURBO_MAX,
-            CPU2_MAX_FREQ_NONTURBO_MAX, CPU3_MAX_FREQ_NONTURBO_MAX };
-        perform_hint_action(DEFAULT_PROFILE_HINT_ID,
-            resource_values, ARRAY_SIZE(resource_values));
+        configured_hint_action(BOOST_PROFILE_POWER_SAVE,
+                DEFAULT_PROFILE_HINT_ID, builtin_boost_lists);
         ALOGD("%s: set powersave", __func__);
+    } else if (current_power_profile != PROFILE_BALANCED) {
+        undo_hint_action(DEFAULT_PROFILE_HINT_ID);
+        ALOGV("%s: hint undone", __func__);
     }
 
     current_power_profile = profile;
 }
 
-extern void interaction(int duration, int num_args, int opt_list[]);
+extern void interaction(int duration, int num_args, const int opt_list[]);
 
 int power_hint_override(__attribute__((unused)) struct power_module *module,
         power_hint_t hint, void *data)
@@ -142,31 +175,24 @@ int power_hint_override(__attribute__((unused)) struct power_module *module,
 
     if (hint == POWER_HINT_LAUNCH) {
         int duration = 2000;
-        int resources[] = { CPUS_ONLINE_MIN_3,
-            CPU0_MIN_FREQ_TURBO_MAX, CPU1_MIN_FREQ_TURBO_MAX,
-            CPU2_MIN_FREQ_TURBO_MAX, CPU3_MIN_FREQ_TURBO_MAX };
 
-        interaction(duration, ARRAY_SIZE(resources), resources);
+        configured_interaction(BOOST_LAUNCH, duration, builtin_boost_lists);
 
         return HINT_HANDLED;
     }
 
     if (hint == POWER_HINT_CPU_BOOST) {
         int duration = *(int32_t *)data / 1000;
-        int resources[] = { CPUS_ONLINE_MIN_2,
-            0x20F, 0x30F, 0x40F, 0x50F };
 
         if (duration)
-            interaction(duration, ARRAY_SIZE(resources), resources);
+            configured_interaction(BOOST_CPU_BOOST, duration,
+                    builtin_boost_lists);
 
         return HINT_HANDLED;
     }
 
     if (hint == POWER_HINT_INTERACTION) {
         int duration = 500, duration_hint = 0;
-        static struct timespec s_previous_boost_timespec;
-        struct timespec cur_boost_timespec;
-        long long elapsed_time;
 
         if (data) {
             duration_hint = *((int *)data);
@@ -174,23 +200,15 @@ int power_hint_override(__attribute__((unused)) struct power_module *module,
 
         duration = duration_hint > 0 ? duration_hint : 500;
 
-        clock_gettime(CLOCK_MONOTONIC, &cur_boost_timespec);
-        elapsed_time = calc_timespan_us(s_previous_boost_timespec, cur_boost_timespec);
-        if (elapsed_time > 750000)
-            elapsed_time = 750000;
-        // don't hint if it's been less than 250ms since last boost
-        // also detect if we're doing anything resembling a fling
-        // support additional boosting in case of flings
-        else if (elapsed_time < 250000 && duration <= 750)
+        if (!(duration = adjust_interaction_duration(duration)))
             return HINT_HANDLED;
 
-        s_previous_boost_timespec = cur_boost_timespec;
-
-        int resources[] = { (duration >= 2000 ? CPUS_ONLINE_MIN_3 : CPUS_ONLINE_MIN_2),
-            0x20F, 0x30F, 0x40F, 0x50F };
-
-        if (duration)
-            interaction(duration, ARRAY_SIZE(resources), resources);
+        if (duration >= 2000)
+            configured_interaction(BOOST_INTERACTION_FLING, duration,
+                    builtin_boost_lists);
+        else
+            configured_interaction(BOOST_INTERACTION, duration,
+                    builtin_boost_lists);
 
         return HINT_HANDLED;
     }
@@ -199,11 +217,19 @@ int power_hint_override(__attribute__((unused)) struct power_module *module,
     return HINT_NONE;
 }
 
+static const int display_off_ondemand_resources[] = {
+    MS_500, SYNC_FREQ_600, OPTIMAL_FREQ_600, THREAD_MIGRATION_SYNC_OFF,
+};
+
+static const int display_on_resources[] = {
+    CPUS_ONLINE_MIN_2,
+};
+
 int set_interactive_override(struct power_module *module __unused, int on)
 {
-    char governor[80];
+    int governor;
 
-    if (get_scaling_governor(governor, sizeof(governor)) == -1) {
+    if ((governor = get_scaling_governor_type()) == GOVERNOR_UNKNOWN) {
         ALOGE("Can't obtain scaling governor.");
 
         return HINT_NONE;
@@ -224,25 +250,21 @@ int set_interactive_override(struct power_module *module __unused, int on)
             undo_hint_action(DISPLAY_STATE_HINT_ID_2);
         }
 
-        if ((strncmp(governor, ONDEMAND_GOVERNOR, strlen(ONDEMAND_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(ONDEMAND_GOVERNOR))) {
-            int resource_values[] = {MS_500, SYNC_FREQ_600, OPTIMAL_FREQ_600, THREAD_MIGRATION_SYNC_OFF};
-
+        if (governor == GOVERNOR_ONDEMAND) {
             perform_hint_action(DISPLAY_STATE_HINT_ID,
-                    resource_values, ARRAY_SIZE(resource_values));
+                    display_off_ondemand_resources,
+                    ARRAY_SIZE(display_off_ondemand_resources));
 
             return HINT_HANDLED;
         }
     } else {
         /* Display on */
         if (is_target_8974pro()) {
-            int resource_values2[] = {CPUS_ONLINE_MIN_2};
             perform_hint_action(DISPLAY_STATE_HINT_ID_2,
-                    resource_values2, ARRAY_SIZE(resource_values2));
+                    display_on_resources, ARRAY_SIZE(display_on_resources));
         }
 
-        if ((strncmp(governor, ONDEMAND_GOVERNOR, strlen(ONDEMAND_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(ONDEMAND_GOVERNOR))) {
+        if (governor == GOVERNOR_ONDEMAND) {
             undo_hint_action(DISPLAY_STATE_HINT_ID);
 
             return HINT_HANDLED;
@@ -35,6 +35,7 @@
 #include <fcntl.h>
 #include <dlfcn.h>
 #include <stdlib.h>
+#include <stdatomic.h>
 
 #define LOG_TAG "QCOM PowerHAL"
 #include <utils/Log.h>
@@ -46,12 +47,71 @@
 #include "hint-data.h"
 #include "performance.h"
 #include "power-common.h"
+#include "boost-config.h"
+#include "video-hint.h"
 
 int get_number_of_profiles() {
     return 5;
 }
 
-static int current_power_profile = PROFILE_BALANCED;
+static atomic_int current_power_profile = PROFILE_BALANCED;
+
+static const int profile_power_save[] = {
+    CPUS_ONLINE_MPD_OVERRIDE, 0x0A03,
+    CPU0_MAX_FREQ_NONTURBO_MAX - 2, CPU1_MAX_FREQ_NONTURBO_MAX - 2,
+    CPU2_MAX_FREQ_NONTURBO_MAX - 2, CPU3_MAX_FREQ_NONTURBO_MAX - 2,
+    CPU4_MAX_FREQ_NONTURBO_MAX - 2, CPU5_MAX_FREQ_NONTURBO_MAX - 2,
+};
+
+static const int profile_high_performance[] = {
+    SCHED_BOOST_ON, CPUS_ONLINE_MAX,
+    ALL_CPUS_PWR_CLPS_DIS, 0x0901,
+    CPU0_MIN_FREQ_TURBO_MAX, CPU1_MIN_FREQ_TURBO_MAX,
+    CPU2_MIN_FREQ_TURBO_MAX, CPU3_MIN_FREQ_TURBO_MAX,
+    CPU4_MIN_FREQ_TURBO_MAX, CPU5_MIN_FREQ_TURBO_MAX,
+};
+
+static const int profile_bias_power[] = {
+    0x0A03, 0x0902,
+    CPU0_MAX_FREQ_NONTURBO_MAX - 2, CPU1_MAX_FREQ_NONTURBO_MAX - 2,
+    CPU1_MAX_FREQ_NONTURBO_MAX - 2, CPU2_MAX_FREQ_NONTURBO_MAX - 2,
+    CPU4_MAX_FREQ_NONTURBO_MAX, CPU5_MAX_FREQ_NONTURBO_MAX,
+};
+
+static const int profile_bias_performance[] = {
+    CPUS_ONLINE_MAX_LIMIT_MAX,
+    CPU4_MIN_FREQ_NONTURBO_MAX + 1, CPU5_MIN_FREQ_NONTURBO_MAX + 1,
+};
+
+static const int resources_interaction_fling_boost[] = {
+    ALL_CPUS_PWR_CLPS_DIS,
+    SCHED_BOOST_ON,
+    SCHED_PREFER_IDLE_DIS,
+};
+
+static const int resources_interaction_boost[] = {
+    ALL_CPUS_PWR_CLPS_DIS,
+    SCHED_PREFER_IDLE_DIS,
+};
+
+static const int resources_launch[] = {
+    SCHED_BOOST_ON, 0x20C,
+};
+
+static const int resources_cpu_boost[] = {
+    SCHED_BOOST_ON,
+};
+
+static const struct resource_list builtin_boost_lists[BOOST_LIST_COUNT] = {
+    [BOOST_LAUNCH] = RESOURCE_LIST(resources_launch),
+    [BOOST_INTERACTION] = RESOURCE_LIST(resources_interaction_boost),
+    [BOOST_INTERACTION_FLING] = RESOURCE_LIST(resources_interaction_fling_boost),
+    [BOOST_CPU_BOOST] = RESOURCE_LIST(resources_cpu_boost),
+    [BOOST_PROFILE_POWER_SAVE] = RESOURCE_LIST(profile_power_save),
+    [BOOST_PROFILE_HIGH_PERFORMANCE] = RESOURCE_LIST(profile_high_performance),
+    [BOOST_PROFILE_BIAS_POWER] = RESOURCE_LIST(profile_bias_power),
+    [BOOST_PROFILE_BIAS_PERFORMANCE] = RESOURCE_LIST(profile_bias_performance),
+};
 
 static void set_power_profile(int profile) {
 
@@ -60,99 +120,46 @@ static void set_power_profile(int profile) {
 
     ALOGV("%s: profile=%d", __func__, profile);
 
-    if (current_power_profile != PROFILE_BALANCED) {
-        undo_hint_action(DEFAULT_PROFILE_HINT_ID);
-        ALOGV("%s: hint undone", __func__);
-    }
-
     if (profile == PROFILE_POWER_SAVE) {
-        int resource_values[] = { CPUS_ONLINE_MPD_OVERRIDE, 0x0A03,
-            CPU0_MAX_FREQ_NONTURBO_MAX - 2, CPU1_MAX_FREQ_NONTURBO_MAX - 2,
-            CPU2_MAX_FREQ_NONTURBO_MAX - 2, CPU3_MAX_FREQ_NONTURBO_MAX - 2,
-            CPU4_MAX_FREQ_NONTURBO_MAX - 2, CPU5_MAX_FREQ_NONTURBO_MAX - 2 };
-        perform_hint_action(DEFAULT_PROFILE_HINT_ID,
-            resource_values, ARRAY_SIZE(resource_values));
+        configured_hint_action(BOOST_PROFILE_POWER_SAVE,
+                DEFAULT_PROFILE_HINT_ID, builtin_boost_lists);
         ALOGD("%s: set powersave", __func__);
     } else if (profile == PROFILE_HIGH_PERFORMANCE) {
-        int resource_values[] = { SCHED_BOOST_ON, CPUS_ONLINE_MAX,
-            ALL_CPUS_PWR_CLPS_DIS, 0x0901,
-            CPU0_MIN_FREQ_TURBO_MAX, CPU1_MIN_FREQ_TURBO_MAX,
-            CPU2_MIN_FREQ_TURBO_MAX, CPU3_MIN_FREQ_TURBO_MAX,
-            CPU4_MIN_FREQ_TURBO_MAX, CPU5_MIN_FREQ_TURBO_MAX };
-        perform_hint_action(DEFAULT_PROFILE_HINT_ID,
-            resource_values, ARRAY_SIZE(resource_values));
+        configured_hint_action(BOOST_PROFILE_HIGH_PERFORMANCE,
+                DEFAULT_PROFILE_HINT_ID, builtin_boost_lists);
         ALOGD("%s: set performance mode", __func__);
     } else if (profile == PROFILE_BIAS_POWER) {
-        int resource_values[] = { 0x0A03, 0x0902,
-            CPU0_MAX_FREQ_NONTURBO_MAX - 2, CPU1_MAX_FREQ_NONTURBO_MAX - 2,
-            CPU1_MAX_FREQ_NONTURBO_MAX - 2, CPU2_MAX_FREQ_NONTURBO_MAX - 2,
-            CPU4_MAX_FREQ_NONTURBO_MAX, CPU5_MAX_FREQ_NONTURBO_MAX };
-        perform_hint_action(DEFAULT_PROFILE_HINT_ID,
-            resource_values, ARRAY_SIZE(resource_values));
+        configured_hint_action(BOOST_PROFILE_BIAS_POWER,
+                DEFAULT_PROFILE_HINT_ID, builtin_boost_lists);
         ALOGD("%s: set bias power mode", __func__);
     } else if (profile == PROFILE_BIAS_PERFORMANCE) {
-        int resource_values[] = { CPUS_ONLINE_MAX_LIMIT_MAX,
-            CPU4_MIN_FREQ_NONTURBO_MAX + 1, CPU5_MIN_FREQ_NONTURBO_MAX + 1 };
-        perform_hint_action(DEFAULT_PROFILE_HINT_ID,
-            resource_values, ARRAY_SIZE(resource_values));
+        configured_hint_action(BOOST_PROFILE_BIAS_PERFORMANCE,
+                DEFAULT_PROFILE_HINT_ID, builtin_boost_lists);
         ALOGD("%s: set bias perf mode", __func__);
+    } else if (current_power_profile != PROFILE_BALANCED) {
+        undo_hint_action(DEFAULT_PROFILE_HINT_ID);
+        ALOGV("%s: hint undone", __func__);
     }
 
     current_power_profile = profile;
 }
 
-extern void interaction(int duration, int num_args, int opt_list[]);
-
-static int process_video_encode_hint(void *metadata)
-{
-    char governor[80];
-    struct video_encode_metadata_t video_encode_metadata;
-
-    if (get_scaling_governor(governor, sizeof(governor)) == -1) {
-        ALOGE("Can't obtain scaling governor.");
-
-        return HINT_NONE;
-    }
-
-    /* Initialize encode metadata struct fields */
-    memset(&video_encode_metadata, 0, sizeof(struct video_encode_metadata_t));
-    video_encode_metadata.state = -1;
-    video_encode_metadata.hint_id = DEFAULT_VIDEO_ENCODE_HINT_ID;
+extern void interaction(int duration, int num_args, const int opt_list[]);
 
-    if (metadata) {
-        if (parse_video_encode_metadata((char *)metadata, &video_encode_metadata) ==
-            -1) {
-            ALOGE("Error occurred while parsing metadata.");
-            return HINT_NONE;
-        }
-    } else {
-        return HINT_NONE;
-    }
+/* sched and cpufreq params
+ * hispeed freq - 768 MHz
+ * target load - 90
+ * above_hispeed_delay - 40ms
+ * sched_small_tsk - 50
+ */
+static const int video_encode_interactive[] = {
+    0x2C07, 0x2F5A, 0x2704, 0x4032,
+};
 
-    if (video_encode_metadata.state == 1) {
-        if ((strncmp(governor, INTERACTIVE_GOVERNOR, strlen(INTERACTIVE_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(INTERACTIVE_GOVERNOR))) {
-            /* sched and cpufreq params
-             * hispeed freq - 768 MHz
-             * target load - 90
-             * above_hispeed_delay - 40ms
-             * sched_small_tsk - 50
-             */
-            int resource_values[] = {0x2C07, 0x2F5A, 0x2704, 0x4032};
-
-            perform_hint_action(video_encode_metadata.hint_id,
-                    resource_values, ARRAY_SIZE(resource_values));
-            return HINT_HANDLED;
-        }
-    } else if (video_encode_metadata.state == 0) {
-        if ((strncmp(governor, INTERACTIVE_GOVERNOR, strlen(INTERACTIVE_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(INTERACTIVE_GOVERNOR))) {
-            undo_hint_action(video_encode_metadata.hint_id);
-            return HINT_HANDLED;
-        }
-    }
-    return HINT_NONE;
-}
+static const struct video_hint_resources video_hint_table[] = {
+    VIDEO_HINT_RESOURCES(POWER_HINT_VIDEO_ENCODE, GOVERNOR_INTERACTIVE,
+            video_encode_interactive),
+};
 
 int power_hint_override(__attribute__((unused)) struct power_module *module,
         power_hint_t hint, void *data)
@@ -169,9 +176,6 @@ int power_hint_override(__attribute__((unused)) struct power_module *module,
 
     if (hint == POWER_HINT_INTERACTION) {
         int duration = 500, duration_hint = 0;
-        static struct timespec s_previous_boost_timespec;
-        struct timespec cur_boost_timespec;
-        long long elapsed_time;
 
         if (data) {
             duration_hint = *((int *)data);
@@ -179,66 +183,56 @@ int power_hint_override(__attribute__((unused)) struct power_module *module,
 
         duration = duration_hint > 0 ? duration_hint : 500;
 
-        clock_gettime(CLOCK_MONOTONIC, &cur_boost_timespec);
-        elapsed_time = calc_timespan_us(s_previous_boost_timespec, cur_boost_timespec);
-        if (elapsed_time > 750000)
-            elapsed_time = 750000;
-        // don't hint if it's been less than 250ms since last boost
-        // also detect if we're doing anything resembling a fling
-        // support additional boosting in case of flings
-        else if (elapsed_time < 250000 && duration <= 750)
+        if (!(duration = adjust_interaction_duration(duration)))
             return HINT_HANDLED;
 
-        s_previous_boost_timespec = cur_boost_timespec;
-
         if (duration >= 1500) {
-            int resources[] = {
-                ALL_CPUS_PWR_CLPS_DIS,
-                SCHED_BOOST_ON,
-                SCHED_PREFER_IDLE_DIS
-            };
-            interaction(duration, ARRAY_SIZE(resources), resources);
+            configured_interaction(BOOST_INTERACTION_FLING, duration,
+                    builtin_boost_lists);
         } else {
-            int resources[] = {
-                ALL_CPUS_PWR_CLPS_DIS,
-                SCHED_PREFER_IDLE_DIS
-            };
-            interaction(duration, ARRAY_SIZE(resources), resources);
+            configured_interaction(BOOST_INTERACTION, duration,
+                    builtin_boost_lists);
         }
         return HINT_HANDLED;
     }
 
     if (hint == POWER_HINT_LAUNCH) {
         int duration = 2000;
-        int resources[] = { SCHED_BOOST_ON, 0x20C };
 
-        interaction(duration, ARRAY_SIZE(resources), resources);
+        configured_interaction(BOOST_LAUNCH, duration, builtin_boost_lists);
 
         return HINT_HANDLED;
     }
 
     if (hint == POWER_HINT_CPU_BOOST) {
         int duration = *(int32_t *)data / 1000;
-        int resources[] = { SCHED_BOOST_ON };
 
         if (duration > 0)
-            interaction(duration, ARRAY_SIZE(resources), resources);
+            configured_interaction(BOOST_CPU_BOOST, duration,
+                    builtin_boost_lists);
 
         return HINT_HANDLED;
     }
 
     if (hint == POWER_HINT_VIDEO_ENCODE) {
-        return process_video_encode_hint(data);
+        return process_video_hint(hint, data, video_hint_table,
+                ARRAY_SIZE(video_hint_table));
     }
 
     return HINT_NONE;
 }
 
+// sched upmigrate = 99, sched downmigrate = 95
+// keep the big cores around, but make them very hard to use
+static const int display_off_resources[] = {
+    0x4E63, 0x4F5F,
+};
+
 int set_interactive_override(__attribute__((unused)) struct power_module *module, int on)
 {
-    char governor[80];
+    int governor;
 
-    if (get_scaling_governor(governor, sizeof(governor)) == -1) {
+    if ((governor = get_scaling_governor_type()) == GOVERNOR_UNKNOWN) {
         ALOGE("Can't obtain scaling governor.");
 
         return HINT_NONE;
@@ -246,19 +240,14 @@ int set_interactive_override(__attribute__((unused)) struct power_module *module
 
     if (!on) {
         /* Display off */
-        if ((strncmp(governor, INTERACTIVE_GOVERNOR, strlen(INTERACTIVE_GOVERNOR)) == 0) &&
-            (strlen(governor) == strlen(INTERACTIVE_GOVERNOR))) {
-            // sched upmigrate = 99, sched downmigrate = 95
-            // keep the big cores around, but make them very hard to use
-            int resource_values[] = { 0x4E63, 0x4F5F };
+        if (governor == GOVERNOR_INTERACTIVE) {
             perform_hint_action(DISPLAY_STATE_HINT_ID,
-                    resource_values, ARRAY_SIZE(resource_values));
+                    display_off_resources, ARRAY_SIZE(display_off_resources));
             return HINT_HANDLED;
         }
     } else {
         /* Display on */
-        if ((strncmp(governor, INTERACTIVE_GOVERNOR, strlen(INTERACTIVE_GOVERNOR)) == 0) &&
-            (strlen(governor) == strlen(INTERACTIVE_GOVERNOR))) {
+        if (governor == GOVERNOR_INTERACTIVE) {
             undo_hint_action(DISPLAY_STATE_HINT_ID);
             return HINT_HANDLED;
         }
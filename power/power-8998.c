@@ -35,6 +35,7 @@
 #include <fcntl.h>
 #include <dlfcn.h>
 #include <stdlib.h>
+#include <stdatomic.h>
 
 #define LOG_TAG "QCOM PowerHAL"
 #include <utils/Log.h>
@@ -46,16 +47,18 @@
 #include "hint-data.h"
 #include "performance.h"
 #include "power-common.h"
+#include "boost-config.h"
+#include "video-hint.h"
 
-static int current_power_profile = PROFILE_BALANCED;
+static atomic_int current_power_profile = PROFILE_BALANCED;
 
-extern void interaction(int duration, int num_args, int opt_list[]);
+extern void interaction(int duration, int num_args, const int opt_list[]);
 
 int get_number_of_profiles() {
     return 5;
 }
 
-static int profile_high_performance[] = {
+static const int profile_high_performance[] = {
     SCHED_BOOST_ON_V3, 0x1,
     ALL_CPUS_PWR_CLPS_DIS_V3, 0x1,
     CPUS_ONLINE_MIN_BIG, 0x2,
@@ -64,23 +67,60 @@ static int profile_high_performance[] = {
     MIN_FREQ_LITTLE_CORE_0, 0xFFF,
 };
 
-static int profile_power_save[] = {
+static const int profile_power_save[] = {
     CPUS_ONLINE_MAX_LIMIT_BIG, 0x1,
     MAX_FREQ_BIG_CORE_0, 0x3E8,
     MAX_FREQ_LITTLE_CORE_0, 0x3E8,
 };
 
-static int profile_bias_power[] = {
+static const int profile_bias_power[] = {
     MAX_FREQ_BIG_CORE_0, 0x514,
     MAX_FREQ_LITTLE_CORE_0, 0x3E8,
 };
 
-static int profile_bias_performance[] = {
+static const int profile_bias_performance[] = {
     CPUS_ONLINE_MAX_LIMIT_BIG, 0x2,
     CPUS_ONLINE_MAX_LIMIT_LITTLE, 0x2,
     MIN_FREQ_BIG_CORE_0, 0x578,
 };
 
+static const int resources_launch[] = {
+    SCHED_BOOST_ON_V3, 0x1,
+    MAX_FREQ_BIG_CORE_0, 0x939,
+    MAX_FREQ_LITTLE_CORE_0, 0xFFF,
+    MIN_FREQ_BIG_CORE_0, 0xFFF,
+    MIN_FREQ_LITTLE_CORE_0, 0xFFF,
+    CPUBW_HWMON_MIN_FREQ, 0x8C,
+    ALL_CPUS_PWR_CLPS_DIS_V3, 0x1,
+    STOR_CLK_SCALE_DIS, 0x1,
+};
+
+static const int resources_cpu_boost[] = {
+    SCHED_BOOST_ON_V3, 0x2,
+};
+
+static const int resources_interaction_fling_boost[] = {
+    CPUBW_HWMON_MIN_FREQ, 0x33,
+    MIN_FREQ_BIG_CORE_0, 0x3E8,
+    MIN_FREQ_LITTLE_CORE_0, 0x3E8,
+    SCHED_BOOST_ON_V3, 0x2,
+};
+
+static const int resources_interaction_boost[] = {
+    MIN_FREQ_BIG_CORE_0, 0x3E8,
+};
+
+static const struct resource_list builtin_boost_lists[BOOST_LIST_COUNT] = {
+    [BOOST_LAUNCH] = RESOURCE_LIST(resources_launch),
+    [BOOST_INTERACTION] = RESOURCE_LIST(resources_interaction_boost),
+    [BOOST_INTERACTION_FLING] = RESOURCE_LIST(resources_interaction_fling_boost),
+    [BOOST_CPU_BOOST] = RESOURCE_LIST(resources_cpu_boost),
+    [BOOST_PROFILE_POWER_SAVE] = RESOURCE_LIST(profile_power_save),
+    [BOOST_PROFILE_HIGH_PERFORMANCE] = RESOURCE_LIST(profile_high_performance),
+    [BOOST_PROFILE_BIAS_POWER] = RESOURCE_LIST(profile_bias_power),
+    [BOOST_PROFILE_BIAS_PERFORMANCE] = RESOURCE_LIST(profile_bias_performance),
+};
+
 static void set_power_profile(int profile) {
 
     if (profile == current_power_profile)
@@ -88,146 +128,141 @@ static void set_power_profile(int profile) {
 
     ALOGV("%s: Profile=%d", __func__, profile);
 
-    if (current_power_profile != PROFILE_BALANCED) {
-        undo_hint_action(DEFAULT_PROFILE_HINT_ID);
-        ALOGV("%s: Hint undone", __func__);
-    }
-
     if (profile == PROFILE_POWER_SAVE) {
-        perform_hint_action(DEFAULT_PROFILE_HINT_ID, profile_power_save,
-                ARRAY_SIZE(profile_power_save));
+        configured_hint_action(BOOST_PROFILE_POWER_SAVE,
+                DEFAULT_PROFILE_HINT_ID, builtin_boost_lists);
         ALOGD("%s: Set powersave mode", __func__);
 
     } else if (profile == PROFILE_HIGH_PERFORMANCE) {
-        perform_hint_action(DEFAULT_PROFILE_HINT_ID, profile_high_performance,
-                ARRAY_SIZE(profile_high_performance));
+        configured_hint_action(BOOST_PROFILE_HIGH_PERFORMANCE,
+                DEFAULT_PROFILE_HINT_ID, builtin_boost_lists);
         ALOGD("%s: Set performance mode", __func__);
 
     } else if (profile == PROFILE_BIAS_POWER) {
-        perform_hint_action(DEFAULT_PROFILE_HINT_ID, profile_bias_power,
-                ARRAY_SIZE(profile_bias_power));
+        configured_hint_action(BOOST_PROFILE_BIAS_POWER,
+                DEFAULT_PROFILE_HINT_ID, builtin_boost_lists);
         ALOGD("%s: Set bias power mode", __func__);
 
     } else if (profile == PROFILE_BIAS_PERFORMANCE) {
-        perform_hint_action(DEFAULT_PROFILE_HINT_ID, profile_bias_performance,
-                ARRAY_SIZE(profile_bias_performance));
+        configured_hint_action(BOOST_PROFILE_BIAS_PERFORMANCE,
+                DEFAULT_PROFILE_HINT_ID, builtin_boost_lists);
         ALOGD("%s: Set bias perf mode", __func__);
 
+    } else if (current_power_profile != PROFILE_BALANCED) {
+        undo_hint_action(DEFAULT_PROFILE_HINT_ID);
+        ALOGV("%s: Hint undone", __func__);
     }
 
     current_power_profile = profile;
 }
 
-static int process_video_encode_hint(void *metadata)
-{
-    char governor[80];
-    struct video_encode_metadata_t video_encode_metadata;
+/* 1. cpufreq params
+ *    -above_hispeed_delay for LVT - 40ms
+ *    -go hispeed load for LVT - 95
+ *    -hispeed freq for LVT - 556 MHz
+ *    -target load for LVT - 90
+ *    -above hispeed delay for sLVT - 40ms
+ *    -go hispeed load for sLVT - 95
+ *    -hispeed freq for sLVT - 806 MHz
+ *    -target load for sLVT - 90
+ * 2. bus DCVS set to V2 config:
+ *    -low power ceil mpbs - 2500
+ *    -low power io percent - 50
+ * 3. hysteresis optimization
+ *    -bus dcvs hysteresis tuning
+ *    -sample_ms of 10 ms
+ */
+static const int video_encode_interactive[] = {
+    ABOVE_HISPEED_DELAY_BIG, 0x4,
+    GO_HISPEED_LOAD_BIG, 0x5F,
+    HISPEED_FREQ_BIG, 0x326,
+    TARGET_LOADS_BIG, 0x5A,
+    ABOVE_HISPEED_DELAY_LITTLE, 0x4,
+    GO_HISPEED_LOAD_LITTLE, 0x5F,
+    HISPEED_FREQ_LITTLE, 0x22C,
+    TARGET_LOADS_LITTLE, 0x5A,
+    LOW_POWER_CEIL_MBPS, 0x9C4,
+    LOW_POWER_IO_PERCENT, 0x32,
+    CPUBW_HWMON_V1, 0x0,
+    CPUBW_HWMON_SAMPLE_MS, 0xA,
+};
 
-    if (get_scaling_governor(governor, sizeof(governor)) == -1) {
-        ALOGE("Can't obtain scaling governor.");
+/*
+ * Up to 720p30 the same, but with target loads of 95 and go hispeed loads
+ * of 99 so the clusters stay lower.
+ */
+static const int video_encode_interactive_sd[] = {
+    ABOVE_HISPEED_DELAY_BIG, 0x4,
+    GO_HISPEED_LOAD_BIG, 0x63,
+    HISPEED_FREQ_BIG, 0x326,
+    TARGET_LOADS_BIG, 0x5F,
+    ABOVE_HISPEED_DELAY_LITTLE, 0x4,
+    GO_HISPEED_LOAD_LITTLE, 0x63,
+    HISPEED_FREQ_LITTLE, 0x22C,
+    TARGET_LOADS_LITTLE, 0x5F,
+    LOW_POWER_CEIL_MBPS, 0x9C4,
+    LOW_POWER_IO_PERCENT, 0x32,
+    CPUBW_HWMON_V1, 0x0,
+    CPUBW_HWMON_SAMPLE_MS, 0xA,
+};
 
-        return HINT_NONE;
-    }
+/*
+ * Above 1080p30 the cpufreq and bus restraints cost frames, so only the
+ * bus DCVS hysteresis tuning is kept.
+ */
+static const int video_encode_interactive_uhd[] = {
+    CPUBW_HWMON_V1, 0x0,
+    CPUBW_HWMON_SAMPLE_MS, 0xA,
+};
 
-    /* Initialize encode metadata struct fields */
-    memset(&video_encode_metadata, 0, sizeof(struct video_encode_metadata_t));
-    video_encode_metadata.state = -1;
-    video_encode_metadata.hint_id = DEFAULT_VIDEO_ENCODE_HINT_ID;
+static const struct video_hint_resources video_hint_table[] = {
+    VIDEO_HINT_SCALED(POWER_HINT_VIDEO_ENCODE, GOVERNOR_INTERACTIVE,
+            PIXEL_RATE(1280, 720, 30), video_encode_interactive_sd),
+    VIDEO_HINT_SCALED(POWER_HINT_VIDEO_ENCODE, GOVERNOR_INTERACTIVE,
+            PIXEL_RATE(1920, 1080, 30), video_encode_interactive),
+    VIDEO_HINT_RESOURCES(POWER_HINT_VIDEO_ENCODE, GOVERNOR_INTERACTIVE,
+            video_encode_interactive_uhd),
+};
 
-    if (metadata) {
-        if (parse_video_encode_metadata((char *)metadata, &video_encode_metadata) ==
-            -1) {
-            ALOGE("Error occurred while parsing metadata.");
-            return HINT_NONE;
-        }
-    } else {
-        return HINT_NONE;
-    }
+/*
+ * Camera preview: cap the little cluster, move bus DCVS to its low power
+ * config and stop storage clock scaling.
+ */
+static const int cam_preview_resources[] = {
+    MAX_FREQ_LITTLE_CORE_0, 0x4B0,
+    LOW_POWER_CEIL_MBPS, 0x9C4,
+    LOW_POWER_IO_PERCENT, 0x32,
+    STOR_CLK_SCALE_DIS, 0x1,
+};
 
-    if (video_encode_metadata.state == 1) {
-        if ((strncmp(governor, INTERACTIVE_GOVERNOR, strlen(INTERACTIVE_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(INTERACTIVE_GOVERNOR))) {
-            /* 1. cpufreq params
-             *    -above_hispeed_delay for LVT - 40ms
-             *    -go hispeed load for LVT - 95
-             *    -hispeed freq for LVT - 556 MHz
-             *    -target load for LVT - 90
-             *    -above hispeed delay for sLVT - 40ms
-             *    -go hispeed load for sLVT - 95
-             *    -hispeed freq for sLVT - 806 MHz
-             *    -target load for sLVT - 90
-             * 2. bus DCVS set to V2 config:
-             *    -low power ceil mpbs - 2500
-             *    -low power io percent - 50
-             * 3. hysteresis optimization
-             *    -bus dcvs hysteresis tuning
-             *    -sample_ms of 10 ms
-             */
-            int resource_values[] = {
-                ABOVE_HISPEED_DELAY_BIG, 0x4,
-                GO_HISPEED_LOAD_BIG, 0x5F,
-                HISPEED_FREQ_BIG, 0x326,
-                TARGET_LOADS_BIG, 0x5A,
-                ABOVE_HISPEED_DELAY_LITTLE, 0x4,
-                GO_HISPEED_LOAD_LITTLE, 0x5F,
-                HISPEED_FREQ_LITTLE, 0x22C,
-                TARGET_LOADS_LITTLE, 0x5A,
-                LOW_POWER_CEIL_MBPS, 0x9C4,
-                LOW_POWER_IO_PERCENT, 0x32,
-                CPUBW_HWMON_V1, 0x0,
-                CPUBW_HWMON_SAMPLE_MS, 0xA,
-            };
-
-            perform_hint_action(video_encode_metadata.hint_id,
-                    resource_values, ARRAY_SIZE(resource_values));
-            ALOGI("Video Encode hint start");
-            return HINT_HANDLED;
-        }
-    } else if (video_encode_metadata.state == 0) {
-        if ((strncmp(governor, INTERACTIVE_GOVERNOR, strlen(INTERACTIVE_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(INTERACTIVE_GOVERNOR))) {
-            undo_hint_action(video_encode_metadata.hint_id);
-            ALOGI("Video Encode hint stop");
-            return HINT_HANDLED;
-        }
-    }
-    return HINT_NONE;
+static const struct resource_list cam_preview_list =
+        RESOURCE_LIST(cam_preview_resources);
+
+const struct resource_list *get_cam_preview_resources(void)
+{
+    return &cam_preview_list;
+}
+
+/*
+ * Low-latency audio: a little cluster floor, so the audio thread doesn't
+ * run at the lowest frequency between bursts.
+ */
+static const int audio_resources[] = {
+    MIN_FREQ_LITTLE_CORE_0, 0x300,
+};
+
+static const struct resource_list audio_list = RESOURCE_LIST(audio_resources);
+
+const struct resource_list *get_audio_resources(void)
+{
+    return &audio_list;
 }
 
 int power_hint_override(__unused struct power_module *module,
         power_hint_t hint, void *data)
 {
-    static struct timespec s_previous_boost_timespec;
-    struct timespec cur_boost_timespec;
-    long long elapsed_time;
     int duration;
 
-    int resources_launch[] = {
-        SCHED_BOOST_ON_V3, 0x1,
-        MAX_FREQ_BIG_CORE_0, 0x939,
-        MAX_FREQ_LITTLE_CORE_0, 0xFFF,
-        MIN_FREQ_BIG_CORE_0, 0xFFF,
-        MIN_FREQ_LITTLE_CORE_0, 0xFFF,
-        CPUBW_HWMON_MIN_FREQ, 0x8C,
-        ALL_CPUS_PWR_CLPS_DIS_V3, 0x1,
-        STOR_CLK_SCALE_DIS, 0x1,
-    };
-
-    int resources_cpu_boost[] = {
-        SCHED_BOOST_ON_V3, 0x2,
-    };
-
-    int resources_interaction_fling_boost[] = {
-        CPUBW_HWMON_MIN_FREQ, 0x33,
-        MIN_FREQ_BIG_CORE_0, 0x3E8,
-        MIN_FREQ_LITTLE_CORE_0, 0x3E8,
-        SCHED_BOOST_ON_V3, 0x2,
-    };
-
-    int resources_interaction_boost[] = {
-        MIN_FREQ_BIG_CORE_0, 0x3E8,
-    };
-
     if (hint == POWER_HINT_SET_PROFILE) {
         set_power_profile(*(int32_t *)data);
         return HINT_HANDLED;
@@ -240,26 +275,15 @@ int power_hint_override(__unused struct power_module *module,
     if (hint == POWER_HINT_INTERACTION) {
         duration = data ? *((int *)data) : 500;
 
-        clock_gettime(CLOCK_MONOTONIC, &cur_boost_timespec);
-        elapsed_time = calc_timespan_us(s_previous_boost_timespec, cur_boost_timespec);
-        if (elapsed_time > 750000)
-            elapsed_time = 750000;
-        /**
-         * Don't hint if it's been less than 250ms since last boost
-         * also detect if we're doing anything resembling a fling
-         * support additional boosting in case of flings
-         */
-        else if (elapsed_time < 250000 && duration <= 750)
+        if (!(duration = adjust_interaction_duration(duration)))
             return HINT_HANDLED;
 
-        s_previous_boost_timespec = cur_boost_timespec;
-
         if (duration >= 1500) {
-            interaction(duration, ARRAY_SIZE(resources_interaction_fling_boost),
-                    resources_interaction_fling_boost);
+            configured_interaction(BOOST_INTERACTION_FLING, duration,
+                    builtin_boost_lists);
         } else {
-            interaction(duration, ARRAY_SIZE(resources_interaction_boost),
-                    resources_interaction_boost);
+            configured_interaction(BOOST_INTERACTION, duration,
+                    builtin_boost_lists);
         }
         return HINT_HANDLED;
     }
@@ -267,22 +291,22 @@ int power_hint_override(__unused struct power_module *module,
     if (hint == POWER_HINT_LAUNCH) {
         duration = 2000;
 
-        interaction(duration, ARRAY_SIZE(resources_launch),
-                resources_launch);
+        configured_interaction(BOOST_LAUNCH, duration, builtin_boost_lists);
         return HINT_HANDLED;
     }
 
     if (hint == POWER_HINT_CPU_BOOST) {
         duration = *(int32_t *)data / 1000;
         if (duration > 0) {
-            interaction(duration, ARRAY_SIZE(resources_cpu_boost),
-                    resources_cpu_boost);
+            configured_interaction(BOOST_CPU_BOOST, duration,
+                    builtin_boost_lists);
             return HINT_HANDLED;
         }
     }
 
     if (hint == POWER_HINT_VIDEO_ENCODE)
-        return process_video_encode_hint(data);
+        return process_video_hint(hint, data, video_hint_table,
+                ARRAY_SIZE(video_hint_table));
 
     return HINT_NONE;
 }
@@ -290,9 +314,9 @@ int power_hint_override(__unused struct power_module *module,
 int set_interactive_override(__unused struct power_module *module, int on)
 {
     return HINT_HANDLED; /* Don't excecute this code path, not in use */
-    char governor[80];
+    int governor;
 
-    if (get_scaling_governor(governor, sizeof(governor)) == -1) {
+    if ((governor = get_scaling_governor_type()) == GOVERNOR_UNKNOWN) {
         ALOGE("Can't obtain scaling governor.");
 
         return HINT_NONE;
@@ -300,8 +324,7 @@ int set_interactive_override(__unused struct power_module *module, int on)
 
     if (!on) {
         /* Display off */
-        if ((strncmp(governor, INTERACTIVE_GOVERNOR, strlen(INTERACTIVE_GOVERNOR)) == 0) &&
-            (strlen(governor) == strlen(INTERACTIVE_GOVERNOR))) {
+        if (governor == GOVERNOR_INTERACTIVE) {
             int resource_values[] = {}; /* dummy node */
             perform_hint_action(DISPLAY_STATE_HINT_ID,
                     resource_values, ARRAY_SIZE(resource_values));
@@ -310,8 +333,7 @@ int set_interactive_override(__unused struct power_module *module, int on)
         }
     } else {
         /* Display on */
-        if ((strncmp(governor, INTERACTIVE_GOVERNOR, strlen(INTERACTIVE_GOVERNOR)) == 0) &&
-            (strlen(governor) == strlen(INTERACTIVE_GOVERNOR))) {
+        if (governor == GOVERNOR_INTERACTIVE) {
             undo_hint_action(DISPLAY_STATE_HINT_ID);
             ALOGI("Display Off hint stop");
             return HINT_HANDLED;
@@ -39,6 +39,14 @@
 #define INTERACTIVE_GOVERNOR "interactive"
 #define MSMDCVS_GOVERNOR "msm-dcvs"
 
+enum {
+    GOVERNOR_UNKNOWN = -1,
+    GOVERNOR_OTHER = 0,
+    GOVERNOR_ONDEMAND,
+    GOVERNOR_INTERACTIVE,
+    GOVERNOR_MSMDCVS,
+};
+
 #define HINT_HANDLED (0)
 #define HINT_NONE (-1)
 
@@ -50,127 +50,110 @@
 #include "performance.h"
 #include "power-common.h"
 #include "power-feature.h"
+#include "hint-stats.h"
+#include "boost-config.h"
+#include "platform.h"
+#include "video-hint.h"
+#ifdef ASYNC_HINTS
+#include "hint-executor.h"
+#endif
+
+static const char *slack_nodes[] = {
+    DCVS_CPU0_SLACK_MAX_NODE,
+    DCVS_CPU0_SLACK_MIN_NODE,
+    MPDECISION_SLACK_MAX_NODE,
+    MPDECISION_SLACK_MIN_NODE,
+};
+#define NUM_SLACK_NODES ARRAY_SIZE(slack_nodes)
 
-static int saved_dcvs_cpu0_slack_max = -1;
-static int saved_dcvs_cpu0_slack_min = -1;
-static int saved_mpdecision_slack_max = -1;
-static int saved_mpdecision_slack_min = -1;
+static int saved_slack[NUM_SLACK_NODES] = { -1, -1, -1, -1 };
 static int slack_node_rw_failed = 0;
 static int display_hint_sent;
 
+/*
+ * Hints are serialized per piece of state they change instead of through
+ * one global lock. Boost hints (interaction, launch, cpu boost) take no
+ * lock here: they are debounced with atomics and interaction() guards its
+ * own perflock handle.
+ */
 static pthread_mutex_t hint_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t profile_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t video_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t interactive_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void process_power_hint(struct power_module *module,
+        power_hint_t hint, void *data);
 
 static void power_init(__attribute__((unused))struct power_module *module)
 {
     ALOGI("QCOM power HAL initing.");
-}
-
-static void process_video_decode_hint(void *metadata)
-{
-    char governor[80];
-    struct video_decode_metadata_t video_decode_metadata;
-
-    if (get_scaling_governor(governor, sizeof(governor)) == -1) {
-        ALOGE("Can't obtain scaling governor.");
-
-        return;
-    }
-
-    if (metadata) {
-        ALOGI("Processing video decode hint. Metadata: %s", (char *)metadata);
-    }
-
-    /* Initialize encode metadata struct fields. */
-    memset(&video_decode_metadata, 0, sizeof(struct video_decode_metadata_t));
-    video_decode_metadata.state = -1;
-    video_decode_metadata.hint_id = DEFAULT_VIDEO_DECODE_HINT_ID;
-
-    if (metadata) {
-        if (parse_video_decode_metadata((char *)metadata, &video_decode_metadata) ==
-            -1) {
-            ALOGE("Error occurred while parsing metadata.");
-            return;
-        }
-    } else {
-        return;
-    }
-
-    if (video_decode_metadata.state == 1) {
-        if ((strncmp(governor, ONDEMAND_GOVERNOR, strlen(ONDEMAND_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(ONDEMAND_GOVERNOR))) {
-            int resource_values[] = {THREAD_MIGRATION_SYNC_OFF};
 
-            perform_hint_action(video_decode_metadata.hint_id,
-                    resource_values, ARRAY_SIZE(resource_values));
-        } else if ((strncmp(governor, INTERACTIVE_GOVERNOR, strlen(INTERACTIVE_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(INTERACTIVE_GOVERNOR))) {
-            int resource_values[] = {TR_MS_30, HISPEED_LOAD_90, HS_FREQ_1026, THREAD_MIGRATION_SYNC_OFF};
+    get_platform_info();
+    load_boost_config();
 
-            perform_hint_action(video_decode_metadata.hint_id,
-                    resource_values, ARRAY_SIZE(resource_values));
-        }
-    } else if (video_decode_metadata.state == 0) {
-        if ((strncmp(governor, ONDEMAND_GOVERNOR, strlen(ONDEMAND_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(ONDEMAND_GOVERNOR))) {
-            undo_hint_action(video_decode_metadata.hint_id);
-        } else if ((strncmp(governor, INTERACTIVE_GOVERNOR, strlen(INTERACTIVE_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(INTERACTIVE_GOVERNOR))) {
-            undo_hint_action(video_decode_metadata.hint_id);
-        }
-    }
+#ifdef ASYNC_HINTS
+    if (start_hint_executor(process_power_hint))
+        ALOGE("Running hints synchronously.");
+#endif
 }
 
-static void process_video_encode_hint(void *metadata)
-{
-    char governor[80];
-    struct video_encode_metadata_t video_encode_metadata;
+static const int video_encode_ondemand[] = {
+    IO_BUSY_OFF, SAMPLING_DOWN_FACTOR_1, THREAD_MIGRATION_SYNC_OFF,
+};
 
-    if (get_scaling_governor(governor, sizeof(governor)) == -1) {
-        ALOGE("Can't obtain scaling governor.");
+/* Up to 720p30 a lower hispeed frequency is enough. */
+static const int video_encode_interactive_sd[] = {
+    TR_MS_30, HISPEED_LOAD_90, HS_FREQ_800, THREAD_MIGRATION_SYNC_OFF,
+    INTERACTIVE_IO_BUSY_OFF,
+};
 
-        return;
-    }
+static const int video_encode_interactive[] = {
+    TR_MS_30, HISPEED_LOAD_90, HS_FREQ_1026, THREAD_MIGRATION_SYNC_OFF,
+    INTERACTIVE_IO_BUSY_OFF,
+};
 
-    /* Initialize encode metadata struct fields. */
-    memset(&video_encode_metadata, 0, sizeof(struct video_encode_metadata_t));
-    video_encode_metadata.state = -1;
-    video_encode_metadata.hint_id = DEFAULT_VIDEO_ENCODE_HINT_ID;
+/*
+ * Above 1080p30 the hispeed restraints cost frames, so only keep the
+ * timer rate and migration settings.
+ */
+static const int video_encode_interactive_uhd[] = {
+    TR_MS_30, THREAD_MIGRATION_SYNC_OFF, INTERACTIVE_IO_BUSY_OFF,
+};
 
-    if (metadata) {
-        if (parse_video_encode_metadata((char *)metadata, &video_encode_metadata) ==
-            -1) {
-            ALOGE("Error occurred while parsing metadata.");
-            return;
-        }
-    } else {
-        return;
-    }
+static const int video_decode_ondemand[] = {
+    THREAD_MIGRATION_SYNC_OFF,
+};
 
-    if (video_encode_metadata.state == 1) {
-        if ((strncmp(governor, ONDEMAND_GOVERNOR, strlen(ONDEMAND_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(ONDEMAND_GOVERNOR))) {
-            int resource_values[] = {IO_BUSY_OFF, SAMPLING_DOWN_FACTOR_1, THREAD_MIGRATION_SYNC_OFF};
+static const int video_decode_interactive_sd[] = {
+    TR_MS_30, HISPEED_LOAD_90, HS_FREQ_800, THREAD_MIGRATION_SYNC_OFF,
+};
 
-            perform_hint_action(video_encode_metadata.hint_id,
-                resource_values, ARRAY_SIZE(resource_values));
-        } else if ((strncmp(governor, INTERACTIVE_GOVERNOR, strlen(INTERACTIVE_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(INTERACTIVE_GOVERNOR))) {
-            int resource_values[] = {TR_MS_30, HISPEED_LOAD_90, HS_FREQ_1026, THREAD_MIGRATION_SYNC_OFF,
-                INTERACTIVE_IO_BUSY_OFF};
+static const int video_decode_interactive[] = {
+    TR_MS_30, HISPEED_LOAD_90, HS_FREQ_1026, THREAD_MIGRATION_SYNC_OFF,
+};
 
-            perform_hint_action(video_encode_metadata.hint_id,
-                    resource_values, ARRAY_SIZE(resource_values));
-        }
-    } else if (video_encode_metadata.state == 0) {
-        if ((strncmp(governor, ONDEMAND_GOVERNOR, strlen(ONDEMAND_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(ONDEMAND_GOVERNOR))) {
-            undo_hint_action(video_encode_metadata.hint_id);
-        } else if ((strncmp(governor, INTERACTIVE_GOVERNOR, strlen(INTERACTIVE_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(INTERACTIVE_GOVERNOR))) {
-            undo_hint_action(video_encode_metadata.hint_id);
-        }
-    }
-}
+static const int video_decode_interactive_uhd[] = {
+    TR_MS_30, THREAD_MIGRATION_SYNC_OFF,
+};
+
+static const struct video_hint_resources video_hint_table[] = {
+    VIDEO_HINT_RESOURCES(POWER_HINT_VIDEO_ENCODE, GOVERNOR_ONDEMAND,
+            video_encode_ondemand),
+    VIDEO_HINT_SCALED(POWER_HINT_VIDEO_ENCODE, GOVERNOR_INTERACTIVE,
+            PIXEL_RATE(1280, 720, 30), video_encode_interactive_sd),
+    VIDEO_HINT_SCALED(POWER_HINT_VIDEO_ENCODE, GOVERNOR_INTERACTIVE,
+            PIXEL_RATE(1920, 1080, 30), video_encode_interactive),
+    VIDEO_HINT_RESOURCES(POWER_HINT_VIDEO_ENCODE, GOVERNOR_INTERACTIVE,
+            video_encode_interactive_uhd),
+    VIDEO_HINT_RESOURCES(POWER_HINT_VIDEO_DECODE, GOVERNOR_ONDEMAND,
+            video_decode_ondemand),
+    VIDEO_HINT_SCALED(POWER_HINT_VIDEO_DECODE, GOVERNOR_INTERACTIVE,
+            PIXEL_RATE(1280, 720, 30), video_decode_interactive_sd),
+    VIDEO_HINT_SCALED(POWER_HINT_VIDEO_DECODE, GOVERNOR_INTERACTIVE,
+            PIXEL_RATE(1920, 1080, 30), video_decode_interactive),
+    VIDEO_HINT_RESOURCES(POWER_HINT_VIDEO_DECODE, GOVERNOR_INTERACTIVE,
+            video_decode_interactive_uhd),
+};
 
 int __attribute__ ((weak)) power_hint_override(
         __attribute__((unused)) struct power_module *module,
@@ -180,12 +163,56 @@ int __attribute__ ((weak)) power_hint_override(
     return HINT_NONE;
 }
 
-extern void interaction(int duration, int num_args, int opt_list[]);
+const struct resource_list * __attribute__ ((weak))
+        get_cam_preview_resources(void)
+{
+    return NULL;
+}
 
-static void power_hint(__attribute__((unused)) struct power_module *module, power_hint_t hint,
-        void *data)
+const struct resource_list * __attribute__ ((weak))
+        get_audio_resources(void)
+{
+    return NULL;
+}
+
+extern void interaction(int duration, int num_args, const int opt_list[]);
+
+static pthread_mutex_t *get_hint_mutex(power_hint_t hint)
+{
+    switch (hint) {
+        case POWER_HINT_INTERACTION:
+        case POWER_HINT_LAUNCH:
+        case POWER_HINT_CPU_BOOST:
+            return NULL;
+        case POWER_HINT_SET_PROFILE:
+            return &profile_mutex;
+        case POWER_HINT_VIDEO_ENCODE:
+        case POWER_HINT_VIDEO_DECODE:
+            return &video_mutex;
+        default:
+            return &hint_mutex;
+    }
+}
+
+static void process_power_hint(struct power_module *module,
+        power_hint_t hint, void *data)
 {
-    pthread_mutex_lock(&hint_mutex);
+    pthread_mutex_t *mutex = get_hint_mutex(hint);
+    long long start_us = hint_stats_now_us();
+
+    if (mutex)
+        pthread_mutex_lock(mutex);
+
+    hint_stats_begin();
+
+    /* Camera preview and low-latency audio share the video hints. */
+    if (hint == POWER_HINT_VIDEO_ENCODE && process_cam_preview_hint(data,
+            get_cam_preview_resources()) == HINT_HANDLED)
+        goto out;
+
+    if ((hint == POWER_HINT_VIDEO_ENCODE || hint == POWER_HINT_VIDEO_DECODE) &&
+            process_audio_hint(data, get_audio_resources()) == HINT_HANDLED)
+        goto out;
 
     /* Check if this hint has been overridden. */
     if (power_hint_override(module, hint, data) == HINT_HANDLED) {
@@ -201,17 +228,33 @@ static void power_hint(__attribute__((unused)) struct power_module *module, powe
         case POWER_HINT_LOW_POWER:
         break;
         case POWER_HINT_VIDEO_ENCODE:
-            process_video_encode_hint(data);
-        break;
         case POWER_HINT_VIDEO_DECODE:
-            process_video_decode_hint(data);
+            process_video_hint(hint, data, video_hint_table,
+                    ARRAY_SIZE(video_hint_table));
         break;
         default:
         break;
     }
 
 out:
-    pthread_mutex_unlock(&hint_mutex);
+    hint_stats_end(hint, start_us);
+
+    if (mutex)
+        pthread_mutex_unlock(mutex);
+}
+
+static void power_hint(struct power_module *module, power_hint_t hint,
+        void *data)
+{
+    hint_stats_inc(hint, HINT_STAT_RECEIVED);
+
+#ifdef ASYNC_HINTS
+    /* Hand the hint to the executor thread unless it has to run inline. */
+    if (queue_power_hint(module, hint, data) == 0)
+        return;
+#endif
+
+    process_power_hint(module, hint, data);
 }
 
 int __attribute__ ((weak)) set_interactive_override(
@@ -230,14 +273,68 @@ int __attribute__ ((weak)) get_number_of_profiles()
 extern void cm_power_set_interactive_ext(int on);
 #endif
 
+/*
+ * msm-dcvs targets: stretch the DCVS and mpdecision slack times by 10
+ * while the display is off, and put back the saved values when it turns
+ * on again.
+ */
+static void set_dcvs_slack(int on)
+{
+    struct sysfs_op ops[NUM_SLACK_NODES];
+    char values[NUM_SLACK_NODES][NODE_MAX];
+    int rc = 0;
+    int count = 0;
+    size_t i;
+
+    if (!on) {
+        for (i = 0; i < NUM_SLACK_NODES; i++) {
+            ops[i].path = slack_nodes[i];
+            ops[i].buf = values[i];
+            ops[i].size = NODE_MAX - 1;
+        }
+
+        sysfs_batch(ops, NUM_SLACK_NODES);
+
+        for (i = 0; i < NUM_SLACK_NODES; i++) {
+            if (ops[i].result) {
+                if (!slack_node_rw_failed)
+                    ALOGE("Failed to read from %s", slack_nodes[i]);
+                rc = 1;
+            } else {
+                saved_slack[i] = atoi(values[i]);
+            }
+        }
+    }
+
+    for (i = 0; i < NUM_SLACK_NODES; i++) {
+        if (saved_slack[i] == -1)
+            continue;
+
+        snprintf(values[i], NODE_MAX, "%d",
+                on ? saved_slack[i] : 10 * saved_slack[i]);
+        ops[count].path = slack_nodes[i];
+        ops[count].buf = values[i];
+        ops[count].size = 0;
+        count++;
+    }
+
+    if (sysfs_batch(ops, count)) {
+        for (i = 0; i < (size_t)count; i++) {
+            if (ops[i].result && !slack_node_rw_failed)
+                ALOGE("Failed to write to %s", ops[i].path);
+        }
+        rc = 1;
+    }
+
+    slack_node_rw_failed = rc;
+}
+
 void set_interactive(struct power_module *module, int on)
 {
-    char governor[80];
-    char tmp_str[NODE_MAX];
+    int governor;
     struct video_encode_metadata_t video_encode_metadata;
-    int rc = 0;
 
-    pthread_mutex_lock(&hint_mutex);
+    pthread_mutex_lock(&interactive_mutex);
 
     /**
      * Ignore consecutive display-off hints
@@ -248,6 +345,13 @@ void set_interactive(struct power_module *module, int on)
 
     display_hint_sent = !on;
 
+    /* Nothing to boost for with the screen off. */
+    if (!on)
+        release_interaction_locks();
+
+    if (!on && property_get_bool("debug.power.dump_stats", 0))
+        dump_hint_stats();
+
 #ifdef SET_INTERACTIVE_EXT
     cm_power_set_interactive_ext(on);
 #endif
@@ -258,184 +362,41 @@ void set_interactive(struct power_module *module, int on)
 
     ALOGI("Got set_interactive hint");
 
-    if (get_scaling_governor(governor, sizeof(governor)) == -1) {
+    if ((governor = get_scaling_governor_type()) == GOVERNOR_UNKNOWN) {
         ALOGE("Can't obtain scaling governor.");
         goto out;
     }
 
     if (!on) {
         /* Display off. */
-        if ((strncmp(governor, ONDEMAND_GOVERNOR, strlen(ONDEMAND_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(ONDEMAND_GOVERNOR))) {
+        if (governor == GOVERNOR_ONDEMAND) {
             int resource_values[] = { MS_500, THREAD_MIGRATION_SYNC_OFF };
 
             perform_hint_action(DISPLAY_STATE_HINT_ID,
                     resource_values, ARRAY_SIZE(resource_values));
-        } else if ((strncmp(governor, INTERACTIVE_GOVERNOR, strlen(INTERACTIVE_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(INTERACTIVE_GOVERNOR))) {
+        } else if (governor == GOVERNOR_INTERACTIVE) {
             int resource_values[] = {TR_MS_50, THREAD_MIGRATION_SYNC_OFF};
 
             perform_hint_action(DISPLAY_STATE_HINT_ID,
                     resource_values, ARRAY_SIZE(resource_values));
-        } else if ((strncmp(governor, MSMDCVS_GOVERNOR, strlen(MSMDCVS_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(MSMDCVS_GOVERNOR))) {
+        } else if (governor == GOVERNOR_MSMDCVS) {
             /* Display turned off. */
-            if (sysfs_read(DCVS_CPU0_SLACK_MAX_NODE, tmp_str, NODE_MAX - 1)) {
-                if (!slack_node_rw_failed) {
-                    ALOGE("Failed to read from %s", DCVS_CPU0_SLACK_MAX_NODE);
-                }
-
-                rc = 1;
-            } else {
-                saved_dcvs_cpu0_slack_max = atoi(tmp_str);
-            }
-
-            if (sysfs_read(DCVS_CPU0_SLACK_MIN_NODE, tmp_str, NODE_MAX - 1)) {
-                if (!slack_node_rw_failed) {
-                    ALOGE("Failed to read from %s", DCVS_CPU0_SLACK_MIN_NODE);
-                }
-
-                rc = 1;
-            } else {
-                saved_dcvs_cpu0_slack_min = atoi(tmp_str);
-            }
-
-            if (sysfs_read(MPDECISION_SLACK_MAX_NODE, tmp_str, NODE_MAX - 1)) {
-                if (!slack_node_rw_failed) {
-                    ALOGE("Failed to read from %s", MPDECISION_SLACK_MAX_NODE);
-                }
-
-                rc = 1;
-            } else {
-                saved_mpdecision_slack_max = atoi(tmp_str);
-            }
-
-            if (sysfs_read(MPDECISION_SLACK_MIN_NODE, tmp_str, NODE_MAX - 1)) {
-                if(!slack_node_rw_failed) {
-                    ALOGE("Failed to read from %s", MPDECISION_SLACK_MIN_NODE);
-                }
-
-                rc = 1;
-            } else {
-                saved_mpdecision_slack_min = atoi(tmp_str);
-            }
-
-            /* Write new values. */
-            if (saved_dcvs_cpu0_slack_max != -1) {
-                snprintf(tmp_str, NODE_MAX, "%d", 10 * saved_dcvs_cpu0_slack_max);
-
-                if (sysfs_write(DCVS_CPU0_SLACK_MAX_NODE, tmp_str) != 0) {
-                    if (!slack_node_rw_failed) {
-                        ALOGE("Failed to write to %s", DCVS_CPU0_SLACK_MAX_NODE);
-                    }
-
-                    rc = 1;
-                }
-            }
-
-            if (saved_dcvs_cpu0_slack_min != -1) {
-                snprintf(tmp_str, NODE_MAX, "%d", 10 * saved_dcvs_cpu0_slack_min);
-
-                if (sysfs_write(DCVS_CPU0_SLACK_MIN_NODE, tmp_str) != 0) {
-                    if(!slack_node_rw_failed) {
-                        ALOGE("Failed to write to %s", DCVS_CPU0_SLACK_MIN_NODE);
-                    }
-
-                    rc = 1;
-                }
-            }
-
-            if (saved_mpdecision_slack_max != -1) {
-                snprintf(tmp_str, NODE_MAX, "%d", 10 * saved_mpdecision_slack_max);
-
-                if (sysfs_write(MPDECISION_SLACK_MAX_NODE, tmp_str) != 0) {
-                    if(!slack_node_rw_failed) {
-                        ALOGE("Failed to write to %s", MPDECISION_SLACK_MAX_NODE);
-                    }
-
-                    rc = 1;
-                }
-            }
-
-            if (saved_mpdecision_slack_min != -1) {
-                snprintf(tmp_str, NODE_MAX, "%d", 10 * saved_mpdecision_slack_min);
-
-                if (sysfs_write(MPDECISION_SLACK_MIN_NODE, tmp_str) != 0) {
-                    if(!slack_node_rw_failed) {
-                        ALOGE("Failed to write to %s", MPDECISION_SLACK_MIN_NODE);
-                    }
-
-                    rc = 1;
-                }
-            }
-
-            slack_node_rw_failed = rc;
+            set_dcvs_slack(0);
         }
     } else {
         /* Display on. */
-        if ((strncmp(governor, ONDEMAND_GOVERNOR, strlen(ONDEMAND_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(ONDEMAND_GOVERNOR))) {
+        if (governor == GOVERNOR_ONDEMAND) {
             undo_hint_action(DISPLAY_STATE_HINT_ID);
-        } else if ((strncmp(governor, INTERACTIVE_GOVERNOR, strlen(INTERACTIVE_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(INTERACTIVE_GOVERNOR))) {
+        } else if (governor == GOVERNOR_INTERACTIVE) {
             undo_hint_action(DISPLAY_STATE_HINT_ID);
-        } else if ((strncmp(governor, MSMDCVS_GOVERNOR, strlen(MSMDCVS_GOVERNOR)) == 0) &&
-                (strlen(governor) == strlen(MSMDCVS_GOVERNOR))) {
+        } else if (governor == GOVERNOR_MSMDCVS) {
             /* Display turned on. Restore if possible. */
-            if (saved_dcvs_cpu0_slack_max != -1) {
-                snprintf(tmp_str, NODE_MAX, "%d", saved_dcvs_cpu0_slack_max);
-
-                if (sysfs_write(DCVS_CPU0_SLACK_MAX_NODE, tmp_str) != 0) {
-                    if (!slack_node_rw_failed) {
-                        ALOGE("Failed to write to %s", DCVS_CPU0_SLACK_MAX_NODE);
-                    }
-
-                    rc = 1;
-                }
-            }
-
-            if (saved_dcvs_cpu0_slack_min != -1) {
-                snprintf(tmp_str, NODE_MAX, "%d", saved_dcvs_cpu0_slack_min);
-
-                if (sysfs_write(DCVS_CPU0_SLACK_MIN_NODE, tmp_str) != 0) {
-                    if (!slack_node_rw_failed) {
-                        ALOGE("Failed to write to %s", DCVS_CPU0_SLACK_MIN_NODE);
-                    }
-
-                    rc = 1;
-                }
-            }
-
-            if (saved_mpdecision_slack_max != -1) {
-                snprintf(tmp_str, NODE_MAX, "%d", saved_mpdecision_slack_max);
-
-                if (sysfs_write(MPDECISION_SLACK_MAX_NODE, tmp_str) != 0) {
-                    if (!slack_node_rw_failed) {
-                        ALOGE("Failed to write to %s", MPDECISION_SLACK_MAX_NODE);
-                    }
-
-                    rc = 1;
-                }
-            }
-
-            if (saved_mpdecision_slack_min != -1) {
-                snprintf(tmp_str, NODE_MAX, "%d", saved_mpdecision_slack_min);
-
-                if (sysfs_write(MPDECISION_SLACK_MIN_NODE, tmp_str) != 0) {
-                    if (!slack_node_rw_failed) {
-                        ALOGE("Failed to write to %s", MPDECISION_SLACK_MIN_NODE);
-                    }
-
-                    rc = 1;
-                }
-            }
-
-            slack_node_rw_failed = rc;
+            set_dcvs_slack(1);
         }
     }
 
 out:
-    pthread_mutex_unlock(&hint_mutex);
+    pthread_mutex_unlock(&interactive_mutex);
 }
 
 void set_feature(struct power_module *module, feature_t feature, int state)
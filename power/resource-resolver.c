@@ -0,0 +1,368 @@
+/*
+ * Copyright (C) 2017 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Resource conflict resolver.
+ *
+ * Decodes performance.h resource codes into (resource, value) pairs and
+ * aggregates what every owner (a perflock, a hint_id) asks for. Each
+ * resource keeps its requests ordered strongest first, so the effective
+ * level is always the head of the set: the highest floor for minimums,
+ * the lowest ceiling for maximums. Updates only mark the resources whose
+ * head may have moved; resolver_flush() reports the ones that actually
+ * changed, so callers can batch several updates into one set of writes.
+ *
+ * Understood codes:
+ *  - legacy CPUx_MIN_FREQ / CPUx_MAX_FREQ (level * 100MHz, 0xFE = max),
+ *  - legacy SCHED_BOOST_ON, CPUS_ONLINE_MIN_n and CPUS_ONLINE_MAX_LIMIT_n,
+ *  - v3 MIN/MAX_FREQ_{BIG,LITTLE}_CORE_0 (MHz, 0xFFF = max),
+ *    SCHED_BOOST_ON_V3 and CPUS_ONLINE_{MIN,MAX_LIMIT}_{BIG,LITTLE}.
+ * Other codes are skipped.
+ *
+ * The resolver does no locking of its own.
+ */
+
+#define LOG_NIDEBUG 0
+
+#include <string.h>
+
+#define LOG_TAG "QCOM PowerHAL"
+#include <utils/Log.h>
+
+#include "resource-resolver.h"
+
+_Static_assert(NUM_RESOURCES <= 32, "dirty mask too small");
+
+#define LEGACY_FREQ_MAX_LEVEL 0xFE
+#define V3_FREQ_MAX 0xFFF
+#define V3_OPCODE_MASK 0xF0000000
+#define V3_OPCODE 0x40000000
+#define V3_CLUSTER_MASK 0x00000F00
+#define V3_LITTLE 0x00000100
+
+/*
+ * Big is the cluster with the fastest CPUs, little the slowest. Clusters
+ * whose frequencies aren't known yet are skipped.
+ */
+static int get_v3_cluster(int opcode)
+{
+    const struct platform_info *platform = get_platform_info();
+    int little = (opcode & V3_CLUSTER_MASK) == V3_LITTLE;
+    int best = 0, best_freq = 0;
+    int i;
+
+    for (i = 0; i < platform->num_clusters; i++) {
+        const struct cpu_info *cpu = get_cluster_cpu_info(i);
+
+        if (!cpu || !cpu->max_freq)
+            continue;
+
+        if (!best_freq || (little ? cpu->max_freq < best_freq :
+                cpu->max_freq > best_freq)) {
+            best = i;
+            best_freq = cpu->max_freq;
+        }
+    }
+
+    return best;
+}
+
+/* Rounds kHz up to the next frequency the cluster supports. */
+static int get_cluster_freq(int cluster, long long khz, int max)
+{
+    const struct platform_info *platform = get_platform_info();
+    const struct cpu_info *cpu;
+    int i;
+
+    if (cluster >= platform->num_clusters)
+        return -1;
+
+    cpu = get_cluster_cpu_info(cluster);
+    if (!cpu)
+        return max ? -1 : khz;
+
+    if (max || (cpu->max_freq && khz >= cpu->max_freq))
+        return cpu->max_freq ? cpu->max_freq : -1;
+
+    for (i = 0; i < cpu->num_freqs; i++) {
+        if (cpu->freqs[i] >= khz)
+            return cpu->freqs[i];
+    }
+
+    if (khz < cpu->min_freq)
+        return cpu->min_freq;
+
+    return khz;
+}
+
+static int get_cpu_cluster(int cpu)
+{
+    const struct platform_info *platform = get_platform_info();
+
+    if (cpu < 0 || cpu >= platform->num_cpus)
+        return -1;
+
+    return platform->cpus[cpu].cluster;
+}
+
+struct request_list {
+    struct resource_request *requests;
+    int count;
+    int max;
+};
+
+static void add_request(struct request_list *list, int kind, int cluster,
+        int value)
+{
+    if (cluster < 0 || cluster >= MAX_CLUSTERS || value < 0)
+        return;
+
+    if (list->count == list->max) {
+        ALOGE("Too many resources in one request");
+        return;
+    }
+
+    list->requests[list->count].resource = RESOURCE_ID(kind, cluster);
+    list->requests[list->count].value = value;
+    list->count++;
+}
+
+/* Maps a legacy (MPCTL v2) resource code; the low byte is the level. */
+static void add_legacy_resource(struct request_list *list, int code)
+{
+    int type = (code >> 8) & 0xFF;
+    int level = code & 0xFF;
+    int cluster;
+
+    if (type >= 0x02 && type <= 0x05) {
+        cluster = get_cpu_cluster(type - 0x02);
+        add_request(list, RES_MIN_FREQ, cluster, get_cluster_freq(cluster,
+                level * 100000LL, level >= LEGACY_FREQ_MAX_LEVEL));
+    } else if (type >= 0x1F && type <= 0x22) {
+        cluster = get_cpu_cluster(type - 0x1F + 4);
+        add_request(list, RES_MIN_FREQ, cluster, get_cluster_freq(cluster,
+                level * 100000LL, level >= LEGACY_FREQ_MAX_LEVEL));
+    } else if (type >= 0x15 && type <= 0x18) {
+        cluster = get_cpu_cluster(type - 0x15);
+        add_request(list, RES_MAX_FREQ, cluster, get_cluster_freq(cluster,
+                level * 100000LL, level >= LEGACY_FREQ_MAX_LEVEL));
+    } else if (type >= 0x23 && type <= 0x26) {
+        cluster = get_cpu_cluster(type - 0x23 + 4);
+        add_request(list, RES_MAX_FREQ, cluster, get_cluster_freq(cluster,
+                level * 100000LL, level >= LEGACY_FREQ_MAX_LEVEL));
+    } else if (type == 0x1E) {
+        add_request(list, RES_SCHED_BOOST, 0, level);
+    } else if (type == 0x07 && level <= MAX_CPUS) {
+        add_request(list, RES_CPUS_MIN, 0, level);
+    } else if (type == 0x08 && level >= 0xF0) {
+        add_request(list, RES_CPUS_MAX, 0, 0xFF - level);
+    }
+}
+
+static void add_v3_resource(struct request_list *list, int opcode, int value)
+{
+    int cluster = get_v3_cluster(opcode);
+
+    switch (opcode & ~V3_CLUSTER_MASK) {
+        case 0x40800000: /* MIN_FREQ_*_CORE_0 */
+            add_request(list, RES_MIN_FREQ, cluster, get_cluster_freq(cluster,
+                    value * 1000LL, value >= V3_FREQ_MAX));
+            break;
+        case 0x40804000: /* MAX_FREQ_*_CORE_0 */
+            add_request(list, RES_MAX_FREQ, cluster, get_cluster_freq(cluster,
+                    value * 1000LL, value >= V3_FREQ_MAX));
+            break;
+        case 0x40C00000: /* SCHED_BOOST_ON_V3 */
+            add_request(list, RES_SCHED_BOOST, 0, value);
+            break;
+        case 0x41000000: /* CPUS_ONLINE_MIN_* */
+            add_request(list, RES_CPUS_MIN, cluster, value);
+            break;
+        case 0x41004000: /* CPUS_ONLINE_MAX_LIMIT_* */
+            add_request(list, RES_CPUS_MAX, cluster, value);
+            break;
+        default:
+            break;
+    }
+}
+
+int decode_resources(const int list[], int num_args,
+        struct resource_request requests[], int max_requests)
+{
+    struct request_list out = { requests, 0, max_requests };
+    int i;
+
+    for (i = 0; i < num_args; i++) {
+        if ((list[i] & V3_OPCODE_MASK) == V3_OPCODE) {
+            if (i + 1 < num_args)
+                add_v3_resource(&out, list[i], list[i + 1]);
+            i++;
+        } else {
+            add_legacy_resource(&out, list[i]);
+        }
+    }
+
+    return out.count;
+}
+
+const char *resource_kind_name(int resource)
+{
+    static const char *names[RES_KIND_COUNT] = {
+        [RES_MIN_FREQ] = "min_freq",
+        [RES_MAX_FREQ] = "max_freq",
+        [RES_CPUS_MIN] = "min_cpus",
+        [RES_CPUS_MAX] = "max_cpus",
+        [RES_SCHED_BOOST] = "sched_boost",
+    };
+
+    return names[RESOURCE_KIND(resource)];
+}
+
+/* Floors take the highest request, ceilings the lowest. */
+static int is_stronger(int resource, int value, int than)
+{
+    int kind = RESOURCE_KIND(resource);
+
+    if (kind == RES_MAX_FREQ || kind == RES_CPUS_MAX)
+        return value < than;
+
+    return value > than;
+}
+
+static int find_owner(const struct resource_set *set, int owner)
+{
+    int i;
+
+    for (i = 0; i < set->count; i++) {
+        if (set->entries[i].owner == owner)
+            return i;
+    }
+
+    return -1;
+}
+
+static void remove_entry(struct resource_resolver *resolver, int resource,
+        int index)
+{
+    struct resource_set *set = &resolver->sets[resource];
+
+    memmove(&set->entries[index], &set->entries[index + 1],
+            (set->count - index - 1) * sizeof(set->entries[0]));
+    set->count--;
+
+    if (index == 0)
+        resolver->dirty |= 1U << resource;
+}
+
+static int insert_entry(struct resource_resolver *resolver, int resource,
+        int owner, int value)
+{
+    struct resource_set *set = &resolver->sets[resource];
+    int index = find_owner(set, owner);
+
+    /* Several codes of one owner can land on the same resource. */
+    if (index >= 0) {
+        if (!is_stronger(resource, value, set->entries[index].value))
+            return 0;
+        remove_entry(resolver, resource, index);
+    }
+
+    if (set->count == RESOLVER_MAX_OWNERS) {
+        ALOGE("Too many requests for %s on cluster %d",
+                resource_kind_name(resource), RESOURCE_CLUSTER(resource));
+        return -1;
+    }
+
+    for (index = 0; index < set->count; index++) {
+        if (is_stronger(resource, value, set->entries[index].value))
+            break;
+    }
+
+    memmove(&set->entries[index + 1], &set->entries[index],
+            (set->count - index) * sizeof(set->entries[0]));
+    set->entries[index].owner = owner;
+    set->entries[index].value = value;
+    set->count++;
+
+    if (index == 0)
+        resolver->dirty |= 1U << resource;
+
+    return 0;
+}
+
+void resolver_init(struct resource_resolver *resolver,
+        resource_changed_t changed)
+{
+    int i;
+
+    memset(resolver, 0, sizeof(*resolver));
+
+    for (i = 0; i < NUM_RESOURCES; i++)
+        resolver->effective[i] = -1;
+
+    resolver->changed = changed;
+}
+
+/* Replaces everything owner asked for with requests. */
+int resolver_set(struct resource_resolver *resolver, int owner,
+        const struct resource_request requests[], int num_requests)
+{
+    int rc = 0;
+    int i;
+
+    resolver_clear(resolver, owner);
+
+    for (i = 0; i < num_requests; i++) {
+        if (insert_entry(resolver, requests[i].resource, owner,
+                requests[i].value))
+            rc = -1;
+    }
+
+    return rc;
+}
+
+void resolver_clear(struct resource_resolver *resolver, int owner)
+{
+    int resource, index;
+
+    for (resource = 0; resource < NUM_RESOURCES; resource++) {
+        if ((index = find_owner(&resolver->sets[resource], owner)) >= 0)
+            remove_entry(resolver, resource, index);
+    }
+}
+
+void resolver_flush(struct resource_resolver *resolver)
+{
+    int resource;
+
+    for (resource = 0; resource < NUM_RESOURCES; resource++) {
+        const struct resource_set *set = &resolver->sets[resource];
+        int value;
+
+        if (!(resolver->dirty & (1U << resource)))
+            continue;
+
+        value = set->count ? set->entries[0].value : -1;
+        if (value == resolver->effective[resource])
+            continue;
+
+        resolver->effective[resource] = value;
+        if (resolver->changed)
+            resolver->changed(resource, value);
+    }
+
+    resolver->dirty = 0;
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2017 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _QCOM_RESOURCE_RESOLVER_H
+#define _QCOM_RESOURCE_RESOLVER_H
+
+#include <stdint.h>
+
+#include "platform.h"
+
+enum resource_kind {
+    RES_MIN_FREQ,
+    RES_MAX_FREQ,
+    RES_CPUS_MIN,
+    RES_CPUS_MAX,
+    RES_SCHED_BOOST,
+    RES_KIND_COUNT,
+};
+
+/* A resource is one kind of knob on one cluster. */
+#define NUM_RESOURCES (RES_KIND_COUNT * MAX_CLUSTERS)
+#define RESOURCE_ID(kind, cluster) ((kind) * MAX_CLUSTERS + (cluster))
+#define RESOURCE_KIND(resource) ((resource) / MAX_CLUSTERS)
+#define RESOURCE_CLUSTER(resource) ((resource) % MAX_CLUSTERS)
+
+#define MAX_LOCK_RESOURCES 16
+#define RESOLVER_MAX_OWNERS 64
+
+struct resource_request {
+    int resource;
+    int value;
+};
+
+struct resolver_entry {
+    int owner;
+    int value;
+};
+
+/* Requests for one resource, strongest first. */
+struct resource_set {
+    int count;
+    struct resolver_entry entries[RESOLVER_MAX_OWNERS];
+};
+
+/*
+ * Called from resolver_flush() with a resource's new effective level, or
+ * -1 once nothing requests it any more.
+ */
+typedef void (*resource_changed_t)(int resource, int value);
+
+struct resource_resolver {
+    struct resource_set sets[NUM_RESOURCES];
+    int effective[NUM_RESOURCES];
+    uint32_t dirty;
+    resource_changed_t changed;
+};
+
+int decode_resources(const int list[], int num_args,
+        struct resource_request requests[], int max_requests);
+const char *resource_kind_name(int resource);
+
+void resolver_init(struct resource_resolver *resolver,
+        resource_changed_t changed);
+int resolver_set(struct resource_resolver *resolver, int owner,
+        const struct resource_request requests[], int num_requests);
+void resolver_clear(struct resource_resolver *resolver, int owner);
+void resolver_flush(struct resource_resolver *resolver);
+
+static inline int resolver_level(const struct resource_resolver *resolver,
+        int resource)
+{
+    return resolver->effective[resource];
+}
+
+#endif
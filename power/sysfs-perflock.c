@@ -0,0 +1,302 @@
+/*
+ * Copyright (C) 2017 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Native perflock engine.
+ *
+ * Perflock requests are decoded and aggregated by the resource resolver;
+ * whenever a resource's effective level changes it is written to the
+ * kernel node behind it:
+ *  - min/max frequency -> the cluster's scaling_min_freq/scaling_max_freq,
+ *  - sched boost -> /proc/sys/kernel/sched_boost,
+ *  - online CPU limits -> the cluster's core_ctl min_cpus/max_cpus.
+ * The value a node had before the first request is restored once none
+ * are left. Timed locks are expired in batches by a timer wheel.
+ */
+
+#define LOG_NIDEBUG 0
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOG_TAG "QCOM PowerHAL"
+#include <utils/Log.h>
+
+#include "utils.h"
+#include "platform.h"
+#include "resource-resolver.h"
+#include "sysfs-perflock.h"
+#include "timer-wheel.h"
+
+#define MAX_LOCKS 32
+
+#define SCHED_BOOST_NODE "/proc/sys/kernel/sched_boost"
+#define CORE_CTL_NODE "/sys/devices/system/cpu/cpu%d/core_ctl/%s"
+
+struct resource_state {
+    int saved;      /* Value before the first lock, -1 if not read yet. */
+    int applied;    /* Value last written, -1 if at the saved value. */
+};
+
+struct sysfs_lock {
+    int handle;
+    int timed;
+};
+
+static struct sysfs_lock locks[MAX_LOCKS];
+static struct resource_state resources[NUM_RESOURCES];
+static struct resource_resolver resolver;
+/*
+ * Handle 1 is perfd's boot-time lock, which undo_initial_hint_action()
+ * releases blindly, so never hand it out.
+ */
+#define FIRST_HANDLE 2
+
+static int next_handle = FIRST_HANDLE;
+static int initialized;
+
+/* Expiry timer of locks[i] is lock_timers[i]. */
+static struct timer_entry lock_timers[MAX_LOCKS];
+static struct timer_wheel lock_wheel;
+
+static pthread_mutex_t engine_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int get_resource_path(int resource, char *path, size_t size)
+{
+    int kind = RESOURCE_KIND(resource);
+    int cluster = RESOURCE_CLUSTER(resource);
+    const struct platform_info *platform = get_platform_info();
+
+    if (kind == RES_SCHED_BOOST) {
+        strlcpy(path, SCHED_BOOST_NODE, size);
+        return 0;
+    }
+
+    if (kind == RES_CPUS_MIN || kind == RES_CPUS_MAX) {
+        if (cluster >= platform->num_clusters)
+            return -1;
+        snprintf(path, size, CORE_CTL_NODE,
+                platform->clusters[cluster].first_cpu,
+                kind == RES_CPUS_MIN ? "min_cpus" : "max_cpus");
+        return 0;
+    }
+
+    return -1;
+}
+
+static int read_resource(int resource)
+{
+    int kind = RESOURCE_KIND(resource);
+    char path[80];
+    char buf[32];
+
+    if (kind == RES_MIN_FREQ || kind == RES_MAX_FREQ) {
+        if (cluster_sysfs_read(RESOURCE_CLUSTER(resource),
+                kind == RES_MIN_FREQ ? "scaling_min_freq" : "scaling_max_freq",
+                buf, sizeof(buf)))
+            return -1;
+    } else if (get_resource_path(resource, path, sizeof(path)) ||
+            sysfs_read(path, buf, sizeof(buf))) {
+        return -1;
+    }
+
+    return atoi(buf);
+}
+
+static void write_resource(int resource, int value)
+{
+    int kind = RESOURCE_KIND(resource);
+    char path[80];
+    char buf[32];
+
+    snprintf(buf, sizeof(buf), "%d", value);
+
+    if (kind == RES_MIN_FREQ || kind == RES_MAX_FREQ)
+        cluster_sysfs_write(RESOURCE_CLUSTER(resource),
+                kind == RES_MIN_FREQ ? "scaling_min_freq" : "scaling_max_freq",
+                buf);
+    else if (!get_resource_path(resource, path, sizeof(path)))
+        sysfs_write(path, buf);
+}
+
+/* Resolver callback, runs with engine_lock held. */
+static void apply_resource(int resource, int value)
+{
+    struct resource_state *state = &resources[resource];
+
+    if (value < 0) {
+        if (state->applied >= 0 && state->saved >= 0)
+            write_resource(resource, state->saved);
+        state->applied = -1;
+        return;
+    }
+
+    if (state->saved < 0 && (state->saved = read_resource(resource)) < 0) {
+        /* Node not present on this kernel, leave it alone. */
+        return;
+    }
+
+    write_resource(resource, value);
+    state->applied = value;
+}
+
+static struct sysfs_lock *find_lock(int handle)
+{
+    int i;
+
+    for (i = 0; i < MAX_LOCKS; i++) {
+        if (handle > 0 && locks[i].handle == handle)
+            return &locks[i];
+    }
+
+    return NULL;
+}
+
+static void drop_lock(struct sysfs_lock *lock)
+{
+    if (lock->timed)
+        timer_wheel_del(&lock_wheel, &lock_timers[lock - locks]);
+
+    resolver_clear(&resolver, lock - locks);
+    memset(lock, 0, sizeof(*lock));
+}
+
+/*
+ * Drops a batch of expired locks, re-resolving each resource they held
+ * only once.
+ */
+static void expire_locks(struct timer_entry *expired)
+{
+    pthread_mutex_lock(&engine_lock);
+
+    for (; expired; expired = expired->batch_next) {
+        struct sysfs_lock *lock = &locks[expired - lock_timers];
+
+        /* Released, reused or renewed since the timer fired. */
+        if (!lock->handle || !lock->timed || timer_pending(expired))
+            continue;
+
+        drop_lock(lock);
+    }
+
+    resolver_flush(&resolver);
+
+    pthread_mutex_unlock(&engine_lock);
+}
+
+static void init_engine(void)
+{
+    int i;
+
+    for (i = 0; i < NUM_RESOURCES; i++) {
+        resources[i].saved = -1;
+        resources[i].applied = -1;
+    }
+
+    resolver_init(&resolver, apply_resource);
+    timer_wheel_start(&lock_wheel, expire_locks);
+    initialized = 1;
+}
+
+static struct sysfs_lock *get_free_lock(void)
+{
+    int i;
+
+    for (i = 0; i < MAX_LOCKS; i++) {
+        if (!locks[i].handle)
+            return &locks[i];
+    }
+
+    return NULL;
+}
+
+static int sysfs_perf_lock_acq(unsigned long handle, int duration,
+        int list[], int num_args)
+{
+    struct resource_request requests[MAX_LOCK_RESOURCES];
+    struct sysfs_lock *lock;
+    int num_requests;
+    int was_timed;
+
+    num_requests = decode_resources(list, num_args, requests,
+            MAX_LOCK_RESOURCES);
+
+    pthread_mutex_lock(&engine_lock);
+
+    if (!initialized)
+        init_engine();
+
+    /* A timed lock nobody can expire would stick forever. */
+    if (duration > 0 && !timer_wheel_running(&lock_wheel)) {
+        pthread_mutex_unlock(&engine_lock);
+        return -1;
+    }
+
+    /* Passing a live handle renews that lock, as perfd does. */
+    if (!(lock = find_lock(handle)) && !(lock = get_free_lock())) {
+        pthread_mutex_unlock(&engine_lock);
+        ALOGE("Out of sysfs perflock slots");
+        return -1;
+    }
+
+    if (!lock->handle) {
+        lock->handle = next_handle;
+        next_handle = next_handle == INT_MAX ? FIRST_HANDLE : next_handle + 1;
+    }
+
+    was_timed = lock->timed;
+    lock->timed = duration > 0;
+
+    resolver_set(&resolver, lock - locks, requests, num_requests);
+    resolver_flush(&resolver);
+
+    /* Renewing just moves the timer to its new slot. */
+    if (lock->timed)
+        timer_wheel_add(&lock_wheel, &lock_timers[lock - locks], duration);
+    else if (was_timed)
+        timer_wheel_del(&lock_wheel, &lock_timers[lock - locks]);
+
+    handle = lock->handle;
+
+    pthread_mutex_unlock(&engine_lock);
+
+    return handle;
+}
+
+static int sysfs_perf_lock_rel(unsigned long handle)
+{
+    struct sysfs_lock *lock;
+
+    pthread_mutex_lock(&engine_lock);
+
+    if ((lock = find_lock(handle))) {
+        drop_lock(lock);
+        resolver_flush(&resolver);
+    }
+
+    pthread_mutex_unlock(&engine_lock);
+
+    return lock ? 0 : -1;
+}
+
+const struct perflock_backend sysfs_perflock_backend = {
+    .acq = sysfs_perf_lock_acq,
+    .rel = sysfs_perf_lock_rel,
+    .use_profile = NULL,
+};
@@ -0,0 +1,28 @@
+/*
+ * Copyright (C) 2017 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _QCOM_SYSFS_PERFLOCK_H
+#define _QCOM_SYSFS_PERFLOCK_H
+
+struct perflock_backend;
+
+/*
+ * Perflock backend that applies resource codes with direct sysfs writes,
+ * used when the vendor perf library can't be loaded.
+ */
+extern const struct perflock_backend sysfs_perflock_backend;
+
+#endif
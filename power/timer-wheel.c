@@ -0,0 +1,347 @@
+/*
+ * Copyright (C) 2017 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Hierarchical timer wheel.
+ *
+ * Three levels of 64 slots cover 640ms, 41s and 44min at 10ms a tick.
+ * Adding, renewing and removing a timer is O(1): it's unlinked from
+ * whatever slot holds it and linked into the slot its new deadline falls
+ * in. Higher level slots are cascaded down as the wheel turns.
+ *
+ * One thread sleeps on a timerfd that is armed for the next tick with
+ * work to do, so an idle wheel doesn't wake the CPU. Everything that
+ * expires in a pass is handed to the owner in a single batch.
+ */
+
+#define LOG_NIDEBUG 0
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+
+#define LOG_TAG "QCOM PowerHAL"
+#include <utils/Log.h>
+
+#include "timer-wheel.h"
+
+#define SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+#define LEVEL_SHIFT(level) ((level) * TIMER_WHEEL_BITS)
+#define MAX_TIMEOUT_TICKS \
+        ((1ULL << LEVEL_SHIFT(TIMER_WHEEL_LEVELS)) - 1)
+
+static long long now_us(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec * 1000000LL + now.tv_nsec / 1000;
+}
+
+static uint64_t current_tick(const struct timer_wheel *wheel)
+{
+    return (now_us() - wheel->base_us) / (TIMER_WHEEL_TICK_MS * 1000);
+}
+
+static void unlink_timer(struct timer_entry *timer)
+{
+    *timer->pprev = timer->next;
+    if (timer->next)
+        timer->next->pprev = timer->pprev;
+    timer->next = NULL;
+    timer->pprev = NULL;
+}
+
+static void link_timer(struct timer_entry **head, struct timer_entry *timer)
+{
+    timer->next = *head;
+    if (*head)
+        (*head)->pprev = &timer->next;
+    timer->pprev = head;
+    *head = timer;
+}
+
+/* Files a timer by how far its deadline is from the wheel's position. */
+static void queue_timer(struct timer_wheel *wheel, struct timer_entry *timer)
+{
+    uint64_t expires = timer->expires;
+    uint64_t delta;
+    int level;
+
+    if (expires < wheel->now)
+        expires = wheel->now;
+
+    delta = expires - wheel->now;
+    if (delta > MAX_TIMEOUT_TICKS) {
+        /* Parked in the top level and re-filed when it cascades. */
+        delta = MAX_TIMEOUT_TICKS;
+        expires = wheel->now + delta;
+    }
+
+    for (level = 0; level < TIMER_WHEEL_LEVELS - 1; level++) {
+        if (delta < (1ULL << LEVEL_SHIFT(level + 1)))
+            break;
+    }
+
+    link_timer(&wheel->slots[level][(expires >> LEVEL_SHIFT(level)) & SLOT_MASK],
+            timer);
+}
+
+static void cascade(struct timer_wheel *wheel, int level)
+{
+    int index = (wheel->now >> LEVEL_SHIFT(level)) & SLOT_MASK;
+    struct timer_entry *timer = wheel->slots[level][index];
+
+    wheel->slots[level][index] = NULL;
+
+    while (timer) {
+        struct timer_entry *next = timer->next;
+
+        timer->next = NULL;
+        timer->pprev = NULL;
+        queue_timer(wheel, timer);
+        timer = next;
+    }
+}
+
+/* Turns the wheel up to and including tick, collecting expired timers. */
+static struct timer_entry *advance(struct timer_wheel *wheel, uint64_t tick)
+{
+    struct timer_entry *expired = NULL;
+
+    if (!wheel->num_timers && wheel->now <= tick) {
+        wheel->now = tick + 1;
+        return NULL;
+    }
+
+    while (wheel->now <= tick) {
+        int index = wheel->now & SLOT_MASK;
+        int level;
+
+        for (level = 1; !index && level < TIMER_WHEEL_LEVELS; level++) {
+            cascade(wheel, level);
+            index = (wheel->now >> LEVEL_SHIFT(level)) & SLOT_MASK;
+        }
+        index = wheel->now & SLOT_MASK;
+
+        while (wheel->slots[0][index]) {
+            struct timer_entry *timer = wheel->slots[0][index];
+
+            unlink_timer(timer);
+            timer->batch_next = expired;
+            expired = timer;
+            wheel->num_timers--;
+        }
+
+        wheel->now++;
+    }
+
+    return expired;
+}
+
+/* Returns the earliest tick with work to do: an expiry or a cascade. */
+static uint64_t next_event(const struct timer_wheel *wheel)
+{
+    uint64_t next = 0;
+    int level, i;
+
+    if (!wheel->num_timers)
+        return 0;
+
+    for (i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+        if (wheel->slots[0][(wheel->now + i) & SLOT_MASK]) {
+            next = wheel->now + i;
+            break;
+        }
+    }
+
+    /* A cascade due before the first level 0 expiry may bring it closer. */
+    for (level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+        int shift = LEVEL_SHIFT(level);
+        uint64_t base = (wheel->now + (1ULL << shift) - 1) >> shift;
+
+        for (i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+            if (wheel->slots[level][(base + i) & SLOT_MASK]) {
+                if (!next || ((base + i) << shift) < next)
+                    next = (base + i) << shift;
+                break;
+            }
+        }
+    }
+
+    return next;
+}
+
+static void arm(struct timer_wheel *wheel, uint64_t tick)
+{
+    struct itimerspec spec;
+    long long when_us;
+
+    memset(&spec, 0, sizeof(spec));
+
+    if (tick) {
+        when_us = wheel->base_us + tick * TIMER_WHEEL_TICK_MS * 1000LL;
+        spec.it_value.tv_sec = when_us / 1000000;
+        spec.it_value.tv_nsec = (when_us % 1000000) * 1000;
+    }
+
+    if (timerfd_settime(wheel->timer_fd, TFD_TIMER_ABSTIME, &spec, NULL))
+        ALOGE("Unable to arm timer wheel: %s", strerror(errno));
+
+    wheel->armed = tick;
+}
+
+/* Unlinks every queued timer and returns them as one batch. */
+static struct timer_entry *flush_timers(struct timer_wheel *wheel)
+{
+    struct timer_entry *expired = NULL;
+    int level, i;
+
+    for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        for (i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+            while (wheel->slots[level][i]) {
+                struct timer_entry *timer = wheel->slots[level][i];
+
+                unlink_timer(timer);
+                timer->batch_next = expired;
+                expired = timer;
+            }
+        }
+    }
+
+    wheel->num_timers = 0;
+
+    return expired;
+}
+
+static void *timer_wheel_thread(void *arg)
+{
+    struct timer_wheel *wheel = arg;
+    struct timer_entry *expired;
+    uint64_t count;
+
+    for (;;) {
+        if (read(wheel->timer_fd, &count, sizeof(count)) < 0 &&
+                errno != EINTR) {
+            ALOGE("Timer wheel wakeup failed: %s", strerror(errno));
+
+            /*
+             * Nothing will expire timers from now on, so expire the queued
+             * ones early rather than leave them stuck.
+             */
+            pthread_mutex_lock(&wheel->lock);
+            atomic_store(&wheel->running, 0);
+            expired = flush_timers(wheel);
+            pthread_mutex_unlock(&wheel->lock);
+
+            if (expired)
+                wheel->expire(expired);
+            break;
+        }
+
+        pthread_mutex_lock(&wheel->lock);
+        expired = advance(wheel, current_tick(wheel));
+        arm(wheel, next_event(wheel));
+        pthread_mutex_unlock(&wheel->lock);
+
+        if (expired)
+            wheel->expire(expired);
+    }
+
+    return NULL;
+}
+
+int timer_wheel_start(struct timer_wheel *wheel, timer_expiry_t expire)
+{
+    pthread_attr_t attr;
+    pthread_t thread;
+
+    memset(wheel, 0, sizeof(*wheel));
+    pthread_mutex_init(&wheel->lock, NULL);
+    wheel->expire = expire;
+    wheel->base_us = now_us();
+
+    wheel->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (wheel->timer_fd < 0) {
+        ALOGE("Unable to create timer wheel timerfd: %s", strerror(errno));
+        return -1;
+    }
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+    /* Set first: the thread clears it if it has to give up. */
+    atomic_store(&wheel->running, 1);
+
+    if (pthread_create(&thread, &attr, timer_wheel_thread, wheel)) {
+        ALOGE("Unable to start timer wheel.");
+        atomic_store(&wheel->running, 0);
+        pthread_attr_destroy(&attr);
+        close(wheel->timer_fd);
+        wheel->timer_fd = -1;
+        return -1;
+    }
+
+    pthread_attr_destroy(&attr);
+
+    return 0;
+}
+
+/*
+ * Queues a timer to expire in timeout_ms, or moves it if it's already
+ * queued. Deadlines are rounded up to the next tick.
+ */
+void timer_wheel_add(struct timer_wheel *wheel, struct timer_entry *timer,
+        int timeout_ms)
+{
+    long long tick_us = TIMER_WHEEL_TICK_MS * 1000LL;
+    long long deadline_us = now_us() - wheel->base_us + timeout_ms * 1000LL;
+
+    pthread_mutex_lock(&wheel->lock);
+
+    if (timer_pending(timer)) {
+        unlink_timer(timer);
+    } else if (!wheel->num_timers++) {
+        /* Nothing was queued, so the wheel can just jump ahead. */
+        uint64_t now = current_tick(wheel);
+
+        if (wheel->now < now)
+            wheel->now = now;
+    }
+
+    timer->expires = (deadline_us + tick_us - 1) / tick_us;
+    queue_timer(wheel, timer);
+
+    if (!wheel->armed || timer->expires < wheel->armed)
+        arm(wheel, next_event(wheel));
+
+    pthread_mutex_unlock(&wheel->lock);
+}
+
+void timer_wheel_del(struct timer_wheel *wheel, struct timer_entry *timer)
+{
+    pthread_mutex_lock(&wheel->lock);
+
+    if (timer_pending(timer)) {
+        unlink_timer(timer);
+        wheel->num_timers--;
+    }
+
+    pthread_mutex_unlock(&wheel->lock);
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2017 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _QCOM_TIMER_WHEEL_H
+#define _QCOM_TIMER_WHEEL_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+#define TIMER_WHEEL_TICK_MS 10
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS 3
+
+struct timer_entry {
+    struct timer_entry *next;
+    struct timer_entry **pprev; /* NULL when not queued. */
+    uint64_t expires;           /* In ticks. */
+    struct timer_entry *batch_next;
+};
+
+/*
+ * Called from the wheel thread, without the wheel lock held, with every
+ * timer that expired in one pass chained through ->batch_next. A timer
+ * may be re-added before the callback sees it; timer_pending() tells.
+ */
+typedef void (*timer_expiry_t)(struct timer_entry *expired);
+
+struct timer_wheel {
+    pthread_mutex_t lock;
+    struct timer_entry *slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+    uint64_t now;           /* Next tick to be processed. */
+    uint64_t armed;         /* Tick the timerfd fires at, 0 if disarmed. */
+    long long base_us;      /* Monotonic time of tick 0. */
+    int num_timers;
+    int timer_fd;
+    timer_expiry_t expire;
+    atomic_int running;     /* Cleared if the wheel thread exits. */
+};
+
+int timer_wheel_start(struct timer_wheel *wheel, timer_expiry_t expire);
+void timer_wheel_add(struct timer_wheel *wheel, struct timer_entry *timer,
+        int timeout_ms);
+void timer_wheel_del(struct timer_wheel *wheel, struct timer_entry *timer);
+
+/* Timers only expire while this is true. */
+static inline int timer_wheel_running(struct timer_wheel *wheel)
+{
+    return atomic_load(&wheel->running);
+}
+
+static inline int timer_pending(const struct timer_entry *timer)
+{
+    return timer->pprev != NULL;
+}
+
+#endif
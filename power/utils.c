@@ -33,12 +33,22 @@
 #include <errno.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdio.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/inotify.h>
 #include <sys/stat.h>
 
 #include "utils.h"
-#include "list.h"
 #include "hint-data.h"
+#include "hint-stats.h"
+#include "platform.h"
 #include "power-common.h"
+#include "resource-resolver.h"
+#include "sysfs-perflock.h"
 
 #define LOG_TAG "QCOM PowerHAL"
 #include <utils/Log.h>
@@ -46,15 +56,11 @@
 #define USINSEC 1000000L
 #define NSINUS 1000L
 
-#define SOC_ID_0 "/sys/devices/soc0/soc_id"
-#define SOC_ID_1 "/sys/devices/system/soc/soc0/id"
+#ifndef SYSFS_ROOT
+#define SYSFS_ROOT ""
+#endif
 
-char scaling_gov_path[4][80] ={
-    "sys/devices/system/cpu/cpu0/cpufreq/scaling_governor",
-    "sys/devices/system/cpu/cpu1/cpufreq/scaling_governor",
-    "sys/devices/system/cpu/cpu2/cpufreq/scaling_governor",
-    "sys/devices/system/cpu/cpu3/cpufreq/scaling_governor"
-};
+#define CPUFREQ_NODE_PATH "/sys/devices/system/cpu/cpu%d/cpufreq/%s"
 
 static void *qcopt_handle;
 static void *iop_handle;
@@ -64,9 +70,33 @@ static int (*perf_lock_rel)(unsigned long handle);
 static int (*perf_lock_use_profile)(unsigned long handle, int profile);
 static int (*perf_io_prefetch_start)(int, const char*);
 static int (*perf_io_prefetch_stop)();
-static struct list_node active_hint_list_head;
+static struct hint_table active_hints;
+static pthread_mutex_t active_hints_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Effective resource levels of the active hints, for the logs. */
+static struct resource_resolver hint_levels;
+static int hint_levels_initialized;
 static int profile_handle = 0;
 
+/*
+ * Directory that sysfs paths are resolved against. Empty on a device; a
+ * host build can point it at a fake tree with -DSYSFS_ROOT or
+ * set_sysfs_root().
+ */
+static char sysfs_root[PATH_MAX] = SYSFS_ROOT;
+
+static const char *resolve_sysfs_path(const char *path, char *buf,
+        size_t size)
+{
+    if (!sysfs_root[0])
+        return path;
+
+    snprintf(buf, size, "%s%s%s", sysfs_root, path[0] == '/' ? "" : "/",
+            path);
+
+    return buf;
+}
+
 static void *get_qcopt_handle()
 {
     char qcopt_lib_path[PATH_MAX] = {0};
@@ -106,7 +136,8 @@ static void __attribute__ ((constructor)) initialize(void)
     qcopt_handle = get_qcopt_handle();
 
     if (!qcopt_handle) {
-        ALOGE("Failed to get qcopt handle.\n");
+        ALOGE("Failed to get qcopt handle, using sysfs perflocks.\n");
+        set_perflock_backend(&sysfs_perflock_backend);
     } else {
         /*
          * qc-opt handle obtained. Get the perflock acquire/release
@@ -146,8 +177,8 @@ static void __attribute__ ((constructor)) initialize(void)
     return;
 
 fail_qcopt:
-    perf_lock_acq = NULL;
-    perf_lock_rel = NULL;
+    ALOGE("Incomplete qcopt library, using sysfs perflocks.\n");
+    set_perflock_backend(&sysfs_perflock_backend);
     if (qcopt_handle) {
         dlclose(qcopt_handle);
         qcopt_handle = NULL;
@@ -162,8 +193,24 @@ fail_iop:
     }
 }
 
+/*
+ * Replaces the perflock entry points resolved from the qcopt library, e.g.
+ * with a recording stub when running off-device. Must be called before the
+ * first hint.
+ */
+void set_perflock_backend(const struct perflock_backend *backend)
+{
+    perf_lock_acq = backend ? backend->acq : NULL;
+    perf_lock_rel = backend ? backend->rel : NULL;
+    perf_lock_use_profile = backend ? backend->use_profile : NULL;
+}
+
+static void close_sysfs_nodes(void);
+
 static void __attribute__ ((destructor)) cleanup(void)
 {
+    close_sysfs_nodes();
+
     if (qcopt_handle) {
         if (dlclose(qcopt_handle))
             ALOGE("Error occurred while closing qc-opt library.");
@@ -174,58 +221,444 @@ static void __attribute__ ((destructor)) cleanup(void)
     }
 }
 
+/*
+ * Cache of open sysfs nodes. Hot nodes (governor, DCVS slack, min freq)
+ * are touched on every hint, so their fds are kept open and accessed with
+ * pread/pwrite at offset 0 instead of open/read/close on each call.
+ *
+ * Write nodes also remember the last value written, and writing the same
+ * value again is skipped: cpufreq writes take the policy lock in the
+ * kernel. The shadow is dropped when a write fails, when the fd goes
+ * stale, and when a read of the node returns something else, which means
+ * another writer changed it. cpufreq nodes are also written by perfd and
+ * thermal, so before a write to one is skipped the node is read back
+ * through a second cached fd; SYSFS_WRITE_READBACK does the same for
+ * every node.
+ */
+#define SYSFS_NODE_CACHE_SIZE 32
+#define SYSFS_NODE_PATH_MAX 128
+#define SYSFS_NODE_VALUE_MAX 32
+
+struct sysfs_node {
+    char path[SYSFS_NODE_PATH_MAX];
+    int flags;
+    int fd;
+    int readback_fd; /* Write nodes: -1 until opened, -2 if unreadable. */
+    char shadow[SYSFS_NODE_VALUE_MAX]; /* Last value written, "" if unknown. */
+    pthread_mutex_t lock;
+};
+
+static struct sysfs_node sysfs_nodes[SYSFS_NODE_CACHE_SIZE];
+static int sysfs_node_count;
+static pthread_mutex_t sysfs_nodes_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Returns the cache slot for path, creating it if needed. Slots are never
+ * freed, only their fd is dropped, so the pointer stays valid. Returns NULL
+ * if the cache is full or the path does not fit.
+ */
+static struct sysfs_node *find_sysfs_node(const char *path, int flags)
+{
+    int i;
+
+    for (i = 0; i < sysfs_node_count; i++) {
+        if (sysfs_nodes[i].flags == flags &&
+                strcmp(sysfs_nodes[i].path, path) == 0)
+            return &sysfs_nodes[i];
+    }
+
+    return NULL;
+}
+
+static struct sysfs_node *get_sysfs_node(const char *path, int flags)
+{
+    struct sysfs_node *node;
+
+    pthread_mutex_lock(&sysfs_nodes_lock);
+
+    if ((node = find_sysfs_node(path, flags)))
+        goto out;
+
+    if (sysfs_node_count < SYSFS_NODE_CACHE_SIZE &&
+            strlen(path) < SYSFS_NODE_PATH_MAX) {
+        node = &sysfs_nodes[sysfs_node_count++];
+        strlcpy(node->path, path, sizeof(node->path));
+        node->flags = flags;
+        node->fd = -1;
+        node->readback_fd = -1;
+        node->shadow[0] = '\0';
+        pthread_mutex_init(&node->lock, NULL);
+    }
+
+out:
+    pthread_mutex_unlock(&sysfs_nodes_lock);
+
+    return node;
+}
+
+/*
+ * Errors returned by kernfs once the node behind an open fd is gone, e.g.
+ * the cpufreq directory of a CPU that was hotplugged out.
+ */
+static int is_stale_node_error(int err)
+{
+    return err == ENODEV || err == ENOENT || err == ENXIO || err == EBADF;
+}
+
+/* Compares a value as written with one read back, ignoring the newline. */
+static int same_value(const char *written, const char *read, size_t read_len)
+{
+    size_t len = strlen(written);
+
+    while (read_len > 0 && (read[read_len - 1] == '\n' ||
+            read[read_len - 1] == ' '))
+        read_len--;
+
+    return len == read_len && memcmp(written, read, len) == 0;
+}
+
+static int needs_readback(const struct sysfs_node *node)
+{
+#ifdef SYSFS_WRITE_READBACK
+    return 1;
+#else
+    return strstr(node->path, "/cpufreq/") != NULL;
+#endif
+}
+
+/*
+ * Reads the current value of a write node into buf. The fd is opened once
+ * and kept, so this is a single pread on the hint path. Returns 1 if the
+ * node can't be read back at all, -1 on a failed read.
+ *
+ * Must be called with node->lock held.
+ */
+static int read_back_node(struct sysfs_node *node, char *buf, size_t size)
+{
+    char path[PATH_MAX];
+    ssize_t len;
+
+    if (node->readback_fd == -2)
+        return 1;
+
+    if (node->readback_fd < 0 &&
+            (node->readback_fd = open(resolve_sysfs_path(node->path, path,
+                    sizeof(path)), O_RDONLY | O_CLOEXEC)) < 0) {
+        /* Write-only node; don't retry on every write. */
+        node->readback_fd = errno == EACCES ? -2 : -1;
+        return node->readback_fd == -2 ? 1 : -1;
+    }
+
+    len = pread(node->readback_fd, buf, size - 1, 0);
+    if (len < 0) {
+        close(node->readback_fd);
+        node->readback_fd = -1;
+        return -1;
+    }
+
+    buf[len] = '\0';
+
+    return 0;
+}
+
+/* Must be called with node->lock held. */
+static int is_redundant_write(struct sysfs_node *node, const char *s,
+        size_t len)
+{
+    if (!node->shadow[0] || strlen(node->shadow) != len ||
+            memcmp(node->shadow, s, len) != 0)
+        return 0;
+
+    if (needs_readback(node)) {
+        char buf[SYSFS_NODE_VALUE_MAX + 1];
+        int rc = read_back_node(node, buf, sizeof(buf));
+
+        /* A node that can't be read back keeps relying on the shadow. */
+        if (rc < 0 || (rc == 0 && !same_value(node->shadow, buf,
+                strlen(buf)))) {
+            node->shadow[0] = '\0';
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/* Must be called with node->lock held. */
+static void update_shadow(struct sysfs_node *node, const char *s,
+        ssize_t len)
+{
+    if (len < 0 || len >= SYSFS_NODE_VALUE_MAX) {
+        node->shadow[0] = '\0';
+        return;
+    }
+
+    memcpy(node->shadow, s, len);
+    node->shadow[len] = '\0';
+}
+
+/* Drops the shadow of path's write node if a read disagrees with it. */
+static void check_shadow(const char *path, const char *s, ssize_t len)
+{
+    struct sysfs_node *node;
+
+    pthread_mutex_lock(&sysfs_nodes_lock);
+    node = find_sysfs_node(path, O_WRONLY);
+    pthread_mutex_unlock(&sysfs_nodes_lock);
+
+    if (!node)
+        return;
+
+    pthread_mutex_lock(&node->lock);
+    if (node->shadow[0] && !same_value(node->shadow, s, len))
+        node->shadow[0] = '\0';
+    pthread_mutex_unlock(&node->lock);
+}
+
+static ssize_t sysfs_rw(int fd, int flags, char *s, size_t len)
+{
+    if (flags == O_RDONLY)
+        return pread(fd, s, len, 0);
+
+    return pwrite(fd, s, len, 0);
+}
+
+/*
+ * Performs one read or write on path through the node cache. A cached fd
+ * that turns out to be stale is closed and the node reopened once. On
+ * failure returns -1 with errno set; *opened tells whether open() or the
+ * read/write itself failed.
+ */
+static ssize_t sysfs_node_rw(const char *path, int flags, char *s, size_t len,
+        int *opened)
+{
+    struct sysfs_node *node = get_sysfs_node(path, flags);
+    char buf[PATH_MAX];
+    ssize_t count = -1;
+    int cached;
+    int err;
+    int fd;
+
+    *opened = 0;
+
+    if (!node) {
+        /* Cache is full, fall back to a one-shot open. */
+        if ((fd = open(resolve_sysfs_path(path, buf, sizeof(buf)),
+                flags | O_CLOEXEC)) < 0)
+            return -1;
+
+        *opened = 1;
+        count = sysfs_rw(fd, flags, s, len);
+        err = errno;
+        close(fd);
+        errno = err;
+
+        return count;
+    }
+
+    pthread_mutex_lock(&node->lock);
+
+    if (flags == O_WRONLY && is_redundant_write(node, s, len)) {
+        pthread_mutex_unlock(&node->lock);
+        return len;
+    }
+
+    cached = node->fd >= 0;
+
+    for (;;) {
+        if (node->fd < 0 &&
+                (node->fd = open(resolve_sysfs_path(node->path, buf,
+                        sizeof(buf)), flags | O_CLOEXEC)) < 0) {
+            err = errno;
+            *opened = 0;
+            break;
+        }
+
+        *opened = 1;
+        count = sysfs_rw(node->fd, flags, s, len);
+        err = errno;
+
+        if (count >= 0 || !is_stale_node_error(err))
+            break;
+
+        close(node->fd);
+        node->fd = -1;
+        if (node->readback_fd >= 0) {
+            close(node->readback_fd);
+            node->readback_fd = -1;
+        }
+        node->shadow[0] = '\0';
+
+        if (!cached)
+            break;
+
+        /* Node was removed under us, try a fresh fd once. */
+        cached = 0;
+    }
+
+    if (flags == O_WRONLY)
+        update_shadow(node, s, count == (ssize_t)len ? count : -1);
+
+    pthread_mutex_unlock(&node->lock);
+
+    if (flags == O_RDONLY && count >= 0)
+        check_shadow(path, s, count);
+
+    errno = err;
+
+    return count;
+}
+
+/*
+ * Forgets every written value, e.g. after a governor switch recreated the
+ * tunables with their defaults.
+ */
+static void drop_sysfs_shadows(void)
+{
+    int i, count;
+
+    pthread_mutex_lock(&sysfs_nodes_lock);
+    count = sysfs_node_count;
+    pthread_mutex_unlock(&sysfs_nodes_lock);
+
+    for (i = 0; i < count; i++) {
+        pthread_mutex_lock(&sysfs_nodes[i].lock);
+        sysfs_nodes[i].shadow[0] = '\0';
+        pthread_mutex_unlock(&sysfs_nodes[i].lock);
+    }
+}
+
+static void close_sysfs_nodes(void)
+{
+    int i;
+
+    pthread_mutex_lock(&sysfs_nodes_lock);
+
+    for (i = 0; i < sysfs_node_count; i++) {
+        if (sysfs_nodes[i].fd >= 0) {
+            close(sysfs_nodes[i].fd);
+            sysfs_nodes[i].fd = -1;
+        }
+        if (sysfs_nodes[i].readback_fd >= 0)
+            close(sysfs_nodes[i].readback_fd);
+        sysfs_nodes[i].readback_fd = -1;
+        sysfs_nodes[i].shadow[0] = '\0';
+    }
+
+    pthread_mutex_unlock(&sysfs_nodes_lock);
+}
+
+/*
+ * Resolves all sysfs accesses under root instead of /. Must be called
+ * before the first hint; fds cached so far are dropped.
+ */
+void set_sysfs_root(const char *root)
+{
+    strlcpy(sysfs_root, root ? root : "", sizeof(sysfs_root));
+    close_sysfs_nodes();
+}
+
 int sysfs_read(char *path, char *s, int num_bytes)
 {
     char buf[80];
-    int count;
-    int ret = 0;
-    int fd = open(path, O_RDONLY);
+    ssize_t count;
+    int opened;
 
-    if (fd < 0) {
+    if ((count = sysfs_node_rw(path, O_RDONLY, s, num_bytes - 1,
+            &opened)) < 0) {
         strerror_r(errno, buf, sizeof(buf));
-        ALOGE("Error opening %s: %s\n", path, buf);
+        if (!opened)
+            ALOGE("Error opening %s: %s\n", path, buf);
+        else
+            ALOGE("Error reading from %s: %s\n", path, buf);
 
         return -1;
     }
 
-    if ((count = read(fd, s, num_bytes - 1)) < 0) {
-        strerror_r(errno, buf, sizeof(buf));
-        ALOGE("Error writing to %s: %s\n", path, buf);
+    s[count] = '\0';
 
-        ret = -1;
-    } else {
-        s[count] = '\0';
-    }
+    return 0;
+}
+
+/*
+ * Reads a node without keeping its fd in the cache, for nodes that are
+ * only read once at init. Failures are not logged, since such nodes are
+ * often probed speculatively.
+ */
+int sysfs_read_once(const char *path, char *s, int num_bytes)
+{
+    char buf[PATH_MAX];
+    ssize_t count;
+    int fd;
 
+    if ((fd = open(resolve_sysfs_path(path, buf, sizeof(buf)),
+            O_RDONLY | O_CLOEXEC)) < 0)
+        return -1;
+
+    count = read(fd, s, num_bytes - 1);
     close(fd);
 
-    return ret;
+    if (count < 0)
+        return -1;
+
+    s[count] = '\0';
+
+    return 0;
 }
 
 int sysfs_write(char *path, char *s)
 {
     char buf[80];
-    int len;
-    int ret = 0;
-    int fd = open(path, O_WRONLY);
+    int opened;
 
-    if (fd < 0) {
+    if (sysfs_node_rw(path, O_WRONLY, s, strlen(s), &opened) < 0) {
+        sysfs_stats_write_failed();
         strerror_r(errno, buf, sizeof(buf));
-        ALOGE("Error opening %s: %s\n", path, buf);
-        return -1 ;
+        if (!opened)
+            ALOGE("Error opening %s: %s\n", path, buf);
+        else
+            ALOGE("Error writing to %s: %s\n", path, buf);
+
+        return -1;
     }
 
-    len = write(fd, s, strlen(s));
-    if (len < 0) {
-        strerror_r(errno, buf, sizeof(buf));
-        ALOGE("Error writing to %s: %s\n", path, buf);
+    return 0;
+}
 
-        ret = -1;
-    }
+/*
+ * Runs a set of reads and writes through the node cache in one call.
+ * Unlike sysfs_read/sysfs_write nothing is logged; each op's result is
+ * left in ops[i].result (0 or -errno) for the caller to report. Returns
+ * the number of ops that failed.
+ */
+int sysfs_batch(struct sysfs_op ops[], int count)
+{
+    int failed = 0;
+    int opened;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        struct sysfs_op *op = &ops[i];
+        ssize_t len;
+
+        if (op->size > 0) {
+            len = sysfs_node_rw(op->path, O_RDONLY, op->buf, op->size - 1,
+                    &opened);
+            if (len >= 0)
+                op->buf[len] = '\0';
+        } else {
+            len = sysfs_node_rw(op->path, O_WRONLY, op->buf, strlen(op->buf),
+                    &opened);
+            if (len < 0)
+                sysfs_stats_write_failed();
+        }
 
-    close(fd);
+        op->result = len < 0 ? -errno : 0;
+        if (op->result)
+            failed++;
+    }
 
-    return ret;
+    return failed;
 }
 
 int get_scaling_governor(char governor[], int size)
@@ -247,10 +680,196 @@ int get_scaling_governor(char governor[], int size)
     return 0;
 }
 
+/*
+ * The cpu0 scaling governor is cached as one of the GOVERNOR_* values and
+ * refreshed by a watcher thread, so hints do not have to read and compare
+ * the sysfs string each time.
+ */
+static atomic_int scaling_governor = GOVERNOR_UNKNOWN;
+static atomic_int governor_watcher_running;
+
+/*
+ * When the watcher can't be started or exits, hints keep using the last
+ * governor it saw and only re-read sysfs and restart it after a backoff
+ * that doubles with each consecutive failure.
+ */
+#define GOVERNOR_RETRY_MIN_MS 100
+#define GOVERNOR_RETRY_MAX_MS 30000
+
+static _Atomic long long governor_retry_us;
+static atomic_int governor_retry_ms = GOVERNOR_RETRY_MIN_MS;
+
+static void schedule_governor_retry(void)
+{
+    int backoff_ms = atomic_load_explicit(&governor_retry_ms,
+            memory_order_relaxed);
+
+    atomic_store_explicit(&governor_retry_us,
+            hint_stats_now_us() + backoff_ms * 1000LL, memory_order_relaxed);
+    atomic_store_explicit(&governor_retry_ms,
+            backoff_ms * 2 < GOVERNOR_RETRY_MAX_MS ?
+                    backoff_ms * 2 : GOVERNOR_RETRY_MAX_MS,
+            memory_order_relaxed);
+}
+
+static int scaling_governor_from_name(const char *governor)
+{
+    if (strcmp(governor, ONDEMAND_GOVERNOR) == 0)
+        return GOVERNOR_ONDEMAND;
+    if (strcmp(governor, INTERACTIVE_GOVERNOR) == 0)
+        return GOVERNOR_INTERACTIVE;
+    if (strcmp(governor, MSMDCVS_GOVERNOR) == 0)
+        return GOVERNOR_MSMDCVS;
+
+    return GOVERNOR_OTHER;
+}
+
+static int refresh_scaling_governor(void)
+{
+    char governor[80];
+    int type = GOVERNOR_UNKNOWN;
+
+    if (get_scaling_governor(governor, sizeof(governor)) == 0)
+        type = scaling_governor_from_name(governor);
+
+    if (atomic_exchange_explicit(&scaling_governor, type,
+            memory_order_relaxed) != type)
+        drop_sysfs_shadows();
+
+    return type;
+}
+
+/*
+ * Waits for writes to the governor node. inotify reports writes made from
+ * userspace (init scripts, perfd); POLLPRI covers kernels that
+ * sysfs_notify() the attribute. If the node goes away, the thread exits and
+ * the last value read stays cached until the retry backoff has passed.
+ * A watcher that ran for the longest backoff resets it.
+ */
+static void *governor_watcher(void *arg __unused)
+{
+    char events[sizeof(struct inotify_event) + NAME_MAX + 1];
+    struct pollfd fds[2];
+    char governor[80];
+    char buf[PATH_MAX];
+    long long start_us = hint_stats_now_us();
+    const char *path;
+    int inotify_fd;
+    int node_fd;
+
+    path = resolve_sysfs_path(SCALING_GOVERNOR_PATH, buf, sizeof(buf));
+    inotify_fd = inotify_init1(IN_CLOEXEC);
+    node_fd = open(path, O_RDONLY | O_CLOEXEC);
+
+    if (inotify_fd < 0 || node_fd < 0 ||
+            inotify_add_watch(inotify_fd, path,
+                    IN_MODIFY | IN_DELETE_SELF) < 0) {
+        ALOGE("Unable to watch %s: %s", path, strerror(errno));
+        goto out;
+    }
+
+    fds[0].fd = inotify_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = node_fd;
+    fds[1].events = POLLPRI | POLLERR;
+
+    /* Reading the attribute arms POLLPRI. */
+    pread(node_fd, governor, sizeof(governor), 0);
+    refresh_scaling_governor();
+
+    for (;;) {
+        if (poll(fds, ARRAY_SIZE(fds), -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            ssize_t len = read(inotify_fd, events, sizeof(events));
+            struct inotify_event *event = (struct inotify_event *)events;
+
+            if (len <= 0 || (event->mask & (IN_DELETE_SELF | IN_IGNORED)))
+                break;
+        }
+
+        if (fds[1].revents & (POLLPRI | POLLERR)) {
+            if (pread(node_fd, governor, sizeof(governor), 0) < 0)
+                break;
+        }
+
+        if (refresh_scaling_governor() == GOVERNOR_UNKNOWN)
+            break;
+    }
+
+out:
+    if (node_fd >= 0)
+        close(node_fd);
+    if (inotify_fd >= 0)
+        close(inotify_fd);
+
+    if (hint_stats_now_us() - start_us >= GOVERNOR_RETRY_MAX_MS * 1000LL)
+        atomic_store_explicit(&governor_retry_ms, GOVERNOR_RETRY_MIN_MS,
+                memory_order_relaxed);
+    schedule_governor_retry();
+    atomic_store(&governor_watcher_running, 0);
+
+    return NULL;
+}
+
+static void start_governor_watcher(void)
+{
+    pthread_attr_t attr;
+    pthread_t thread;
+    int expected = 0;
+
+    if (!atomic_compare_exchange_strong(&governor_watcher_running,
+            &expected, 1))
+        return;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+    if (pthread_create(&thread, &attr, governor_watcher, NULL)) {
+        ALOGE("Unable to start governor watcher.");
+        schedule_governor_retry();
+        atomic_store(&governor_watcher_running, 0);
+    }
+
+    pthread_attr_destroy(&attr);
+}
+
+/*
+ * Returns the cpu0 scaling governor as a GOVERNOR_* value, or
+ * GOVERNOR_UNKNOWN if it can't be read. Only reads sysfs when the watcher
+ * isn't keeping the cached value up to date and its retry backoff has
+ * passed; until then the last known value is returned.
+ */
+int get_scaling_governor_type(void)
+{
+    int type = atomic_load_explicit(&scaling_governor, memory_order_relaxed);
+
+    if (atomic_load(&governor_watcher_running)) {
+        if (type != GOVERNOR_UNKNOWN)
+            return type;
+    } else if (hint_stats_now_us() < atomic_load_explicit(&governor_retry_us,
+            memory_order_relaxed)) {
+        return type;
+    }
+
+    type = refresh_scaling_governor();
+    start_governor_watcher();
+
+    return type;
+}
+
 int get_scaling_governor_check_cores(char governor[], int size,int core_num)
 {
-   if (sysfs_read(scaling_gov_path[core_num], governor,
-               size) == -1) {
+   char path[80];
+
+   snprintf(path, sizeof(path), CPUFREQ_NODE_PATH, core_num,
+           "scaling_governor");
+
+   if (sysfs_read(path, governor, size) == -1) {
       // Can't obtain the scaling governor. Return.
       return -1;
    }
@@ -263,99 +882,516 @@ int get_scaling_governor_check_cores(char governor[], int size,int core_num)
    return 0;
 }
 
-void interaction(int duration, int num_args, int opt_list[])
+/*
+ * Reads or writes a cpufreq node of a cluster's policy. Every CPU of the
+ * cluster exposes the same policy, so CPUs are tried in order until one
+ * is online; normally the first one answers and only its node is opened.
+ */
+static ssize_t cluster_node_rw(int cluster, const char *node, int flags,
+        char *s, size_t len)
+{
+    const struct platform_info *platform = get_platform_info();
+    unsigned int mask;
+    char path[80];
+    ssize_t count = -1;
+    int opened;
+    int cpu;
+
+    if (cluster < 0 || cluster >= platform->num_clusters)
+        return -1;
+
+    mask = platform->clusters[cluster].cpu_mask;
+
+    for (cpu = 0; cpu < platform->num_cpus && count < 0; cpu++) {
+        if (!(mask & (1u << cpu)))
+            continue;
+
+        snprintf(path, sizeof(path), CPUFREQ_NODE_PATH, cpu, node);
+        count = sysfs_node_rw(path, flags, s, len, &opened);
+    }
+
+    return count;
+}
+
+int cluster_sysfs_read(int cluster, const char *node, char *s, int num_bytes)
+{
+    ssize_t count = cluster_node_rw(cluster, node, O_RDONLY, s,
+            num_bytes - 1);
+
+    if (count < 0) {
+        ALOGE("Error reading %s of cluster %d", node, cluster);
+        return -1;
+    }
+
+    s[count] = '\0';
+
+    return 0;
+}
+
+int cluster_sysfs_write(int cluster, const char *node, char *s)
+{
+    if (cluster_node_rw(cluster, node, O_WRONLY, s, strlen(s)) < 0) {
+        sysfs_stats_write_failed();
+        ALOGE("Error writing %s of cluster %d", node, cluster);
+        return -1;
+    }
+
+    return 0;
+}
+
+int get_cluster_scaling_governor(int cluster, char governor[], int size)
+{
+    int len;
+
+    if (cluster_sysfs_read(cluster, "scaling_governor", governor, size))
+        return -1;
+
+    // Strip newline at the end.
+    len = strlen(governor) - 1;
+    while (len >= 0 && (governor[len] == '\n' || governor[len] == '\r'))
+        governor[len--] = '\0';
+
+    return 0;
+}
+
+/*
+ * Adaptive interaction boost.
+ *
+ * The last few interaction hints are kept in a small ring. A run of hints
+ * arriving less than INTERACTION_STREAM_GAP_MS apart is taken as a
+ * continuous scroll: each boost then only needs to bridge the gap to the
+ * next expected hint, so it is sized to three times the average gap. A
+ * fast stream gets shorter boosts that end soon after the finger stops,
+ * and a slow one longer boosts that don't lapse between hints. Flings
+ * (long durations) are left alone.
+ *
+ * A hint is dropped only while the boost already running still covers at
+ * least half of what it asks for. Unlike a fixed 250ms window, this never
+ * drops the first hint of a new gesture once the previous boost has run
+ * out.
+ *
+ * Everything here is done with atomics, so dropped hints never take a
+ * lock. Readers may see a slot mid-update; that only skews one estimate.
+ */
+#define INTERACTION_HISTORY 8
+#define INTERACTION_STREAM_GAP_MS 300
+#define INTERACTION_STREAM_MIN_GAPS 3
+#define INTERACTION_MIN_BOOST_MS 100
+#define INTERACTION_FLING_MS 750
+
+static struct {
+    _Atomic long long time_us[INTERACTION_HISTORY];
+    atomic_uint count;
+    _Atomic long long boost_end_us;
+} interaction_history;
+
+static void record_interaction(long long now_us)
+{
+    unsigned int slot = atomic_fetch_add_explicit(&interaction_history.count,
+            1, memory_order_relaxed);
+
+    atomic_store_explicit(&interaction_history.time_us[slot %
+            INTERACTION_HISTORY], now_us, memory_order_relaxed);
+}
+
+static long long interaction_time(unsigned int slot)
+{
+    return atomic_load_explicit(&interaction_history.time_us[slot %
+            INTERACTION_HISTORY], memory_order_relaxed);
+}
+
+/* Returns the mean gap in ms of the current hint stream, or 0 if none. */
+static int get_interaction_stream_gap(void)
+{
+    unsigned int newest = atomic_load_explicit(&interaction_history.count,
+            memory_order_relaxed) - 1;
+    long long newer, older;
+    long long total = 0;
+    int gaps = 0;
+    int i;
+
+    for (i = 1; i < INTERACTION_HISTORY && i <= (int)newest; i++) {
+        newer = interaction_time(newest - i + 1);
+        older = interaction_time(newest - i);
+
+        if (newer <= older ||
+                newer - older >= INTERACTION_STREAM_GAP_MS * 1000LL)
+            break;
+
+        total += newer - older;
+        gaps++;
+    }
+
+    if (gaps < INTERACTION_STREAM_MIN_GAPS)
+        return 0;
+
+    return total / gaps / 1000;
+}
+
+/*
+ * Returns the duration in ms to boost for, or 0 if the hint should be
+ * dropped.
+ */
+int adjust_interaction_duration(int duration)
+{
+    struct timespec now;
+    long long now_us, end_us;
+    int gap;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    now_us = now.tv_sec * USINSEC + now.tv_nsec / NSINUS;
+
+    record_interaction(now_us);
+
+    if (duration <= INTERACTION_FLING_MS &&
+            (gap = get_interaction_stream_gap()) > 0) {
+        duration = gap * 3;
+
+        if (duration < INTERACTION_MIN_BOOST_MS)
+            duration = INTERACTION_MIN_BOOST_MS;
+        if (duration > INTERACTION_FLING_MS)
+            duration = INTERACTION_FLING_MS;
+    }
+
+    end_us = atomic_load_explicit(&interaction_history.boost_end_us,
+            memory_order_relaxed);
+    do {
+        if ((end_us - now_us) * 2 >= duration * 1000LL) {
+            hint_stats_inc(POWER_HINT_INTERACTION, HINT_STAT_DEBOUNCED);
+            return 0;
+        }
+        /* Not covered, so this always pushes the end out. */
+    } while (!atomic_compare_exchange_weak_explicit(
+            &interaction_history.boost_end_us, &end_us,
+            now_us + duration * 1000LL, memory_order_relaxed,
+            memory_order_relaxed));
+
+    return duration;
+}
+
+/*
+ * Timed interaction perflocks, one per distinct resource list.
+ *
+ * A boost whose list is already held only has its deadline pushed out:
+ * if the running lock still outlasts the request nothing is sent to
+ * perfd, otherwise the same handle is renewed. A boost with a new list
+ * gets its own handle and releases the locks it fully supersedes, i.e.
+ * those that would have expired before it anyway and whose resources it
+ * holds too. Lists longer than INTERACTION_LOCK_MAX_ARGS aren't tracked.
+ */
+#define INTERACTION_LOCKS 4
+#define INTERACTION_LOCK_MAX_ARGS 32
+
+/* v3 opcodes are followed by their value; legacy codes stand alone. */
+#define RESOURCE_V3_OPCODE_MASK 0xF0000000
+#define RESOURCE_V3_OPCODE 0x40000000
+
+struct interaction_lock {
+    uint32_t hash;
+    int num_args;
+    int handle;
+    long long deadline_us;
+    int opt_list[INTERACTION_LOCK_MAX_ARGS];
+};
+
+static struct interaction_lock interaction_locks[INTERACTION_LOCKS];
+static pthread_mutex_t interaction_locks_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* FNV-1a over the resource list. */
+static uint32_t hash_resource_list(int num_args, const int opt_list[])
+{
+    uint32_t hash = 2166136261u;
+    int i;
+
+    for (i = 0; i < num_args; i++) {
+        hash ^= (uint32_t)opt_list[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static int lock_holds_list(const struct interaction_lock *lock,
+        uint32_t hash, int num_args, const int opt_list[])
+{
+    return lock->hash == hash && lock->num_args == num_args &&
+            !memcmp(lock->opt_list, opt_list, num_args * sizeof(opt_list[0]));
+}
+
+/* Number of ints the resource starting at list[i] takes. */
+static int resource_code_len(const int list[], int num_args, int i)
+{
+    if ((list[i] & RESOURCE_V3_OPCODE_MASK) == RESOURCE_V3_OPCODE &&
+            i + 1 < num_args)
+        return 2;
+
+    return 1;
+}
+
+/* Returns 1 if every resource the lock holds is also in opt_list. */
+static int list_covers_lock(int num_args, const int opt_list[],
+        const struct interaction_lock *lock)
+{
+    int i, j, len;
+
+    for (i = 0; i < lock->num_args; i += len) {
+        len = resource_code_len(lock->opt_list, lock->num_args, i);
+
+        for (j = 0; j < num_args;
+                j += resource_code_len(opt_list, num_args, j)) {
+            if (j + len <= num_args && !memcmp(&opt_list[j],
+                    &lock->opt_list[i], len * sizeof(opt_list[0])))
+                break;
+        }
+
+        if (j >= num_args)
+            return 0;
+    }
+
+    return 1;
+}
+
+static void release_interaction_lock(struct interaction_lock *lock)
 {
-    static int lock_handle = 0;
+    if (lock->handle > 0 && perf_lock_rel)
+        perf_lock_rel(lock->handle);
+
+    memset(lock, 0, sizeof(*lock));
+}
+
+void interaction(int duration, int num_args, const int opt_list[])
+{
+    struct interaction_lock *lock = NULL;
+    struct interaction_lock *free_lock = NULL;
+    long long start_us, deadline_us;
+    uint32_t hash;
+    int handle;
+    int i;
 
     if (duration <= 0 || num_args < 1 || opt_list[0] == 0)
         return;
 
-    if (qcopt_handle) {
-        if (perf_lock_acq) {
-            lock_handle = perf_lock_acq(lock_handle, duration, opt_list, num_args);
-            if (lock_handle == -1)
-                ALOGE("Failed to acquire lock.");
+    if (!perf_lock_acq)
+        return;
+
+    hash = hash_resource_list(num_args, opt_list);
+    start_us = hint_stats_now_us();
+    deadline_us = start_us + duration * 1000LL;
+
+    pthread_mutex_lock(&interaction_locks_lock);
+
+    for (i = 0; i < INTERACTION_LOCKS; i++) {
+        struct interaction_lock *entry = &interaction_locks[i];
+
+        if (entry->handle > 0 && entry->deadline_us <= start_us)
+            memset(entry, 0, sizeof(*entry)); /* Expired in perfd. */
+
+        if (entry->handle <= 0) {
+            if (!free_lock)
+                free_lock = entry;
+        } else if (lock_holds_list(entry, hash, num_args, opt_list)) {
+            lock = entry;
         }
     }
+
+    if (lock && lock->deadline_us >= deadline_us)
+        goto out;
+
+    if (!lock) {
+        /* Reuse the slot that expires first if all are busy. */
+        if (!(lock = free_lock)) {
+            lock = &interaction_locks[0];
+            for (i = 1; i < INTERACTION_LOCKS; i++) {
+                if (interaction_locks[i].deadline_us < lock->deadline_us)
+                    lock = &interaction_locks[i];
+            }
+            release_interaction_lock(lock);
+        }
+    }
+
+    /* perf_lock_acq() takes a non-const list but doesn't modify it. */
+    handle = perf_lock_acq(lock->handle, duration, (int *)opt_list, num_args);
+    perflock_stats_acquire(start_us, handle == -1);
+    hint_stats_action(handle == -1);
+
+    if (handle == -1) {
+        ALOGE("Failed to acquire lock.");
+        memset(lock, 0, sizeof(*lock));
+        goto out;
+    }
+
+    if (num_args > INTERACTION_LOCK_MAX_ARGS) {
+        /* Left to expire in perfd. */
+        memset(lock, 0, sizeof(*lock));
+        goto out;
+    }
+
+    lock->hash = hash;
+    lock->num_args = num_args;
+    lock->handle = handle;
+    lock->deadline_us = deadline_us;
+    memcpy(lock->opt_list, opt_list, num_args * sizeof(opt_list[0]));
+
+    for (i = 0; i < INTERACTION_LOCKS; i++) {
+        struct interaction_lock *entry = &interaction_locks[i];
+
+        if (entry != lock && entry->handle > 0 &&
+                entry->deadline_us <= deadline_us &&
+                list_covers_lock(num_args, opt_list, entry))
+            release_interaction_lock(entry);
+    }
+
+out:
+    pthread_mutex_unlock(&interaction_locks_lock);
 }
 
-void perform_hint_action(int hint_id, int resource_values[], int num_resources)
+/* Drops all interaction boosts, e.g. when the display turns off. */
+void release_interaction_locks(void)
 {
-    if (qcopt_handle) {
-        if (perf_lock_acq) {
-            /* Acquire an indefinite lock for the requested resources. */
-            int lock_handle = perf_lock_acq(0, 0, resource_values,
-                    num_resources);
+    int i;
 
-            if (lock_handle == -1) {
-                ALOGE("Failed to acquire lock.");
-            } else {
-                /* Add this handle to our internal hint-list. */
-                struct hint_data *new_hint =
-                    (struct hint_data *)malloc(sizeof(struct hint_data));
-
-                if (new_hint) {
-                    if (!active_hint_list_head.compare) {
-                        active_hint_list_head.compare =
-                            (int (*)(void *, void *))hint_compare;
-                        active_hint_list_head.dump = (void (*)(void *))hint_dump;
-                    }
-
-                    new_hint->hint_id = hint_id;
-                    new_hint->perflock_handle = lock_handle;
-
-                    if (add_list_node(&active_hint_list_head, new_hint) == NULL) {
-                        free(new_hint);
-                        /* Can't keep track of this lock. Release it. */
-                        if (perf_lock_rel)
-                            perf_lock_rel(lock_handle);
-
-                        ALOGE("Failed to process hint.");
-                    }
-                } else {
-                    /* Can't keep track of this lock. Release it. */
-                    if (perf_lock_rel)
-                        perf_lock_rel(lock_handle);
-
-                    ALOGE("Failed to process hint.");
-                }
+    pthread_mutex_lock(&interaction_locks_lock);
+
+    for (i = 0; i < INTERACTION_LOCKS; i++)
+        release_interaction_lock(&interaction_locks[i]);
+
+    pthread_mutex_unlock(&interaction_locks_lock);
+}
+
+static void log_hint_level(int resource, int value)
+{
+    if (value < 0)
+        ALOGD("%s on cluster %d released", resource_kind_name(resource),
+                RESOURCE_CLUSTER(resource));
+    else
+        ALOGD("%s on cluster %d now %d", resource_kind_name(resource),
+                RESOURCE_CLUSTER(resource), value);
+}
+
+/* Must be called with active_hints_lock held. */
+static void update_hint_levels(int hint_id, const int resource_values[],
+        int num_resources)
+{
+    struct resource_request requests[MAX_LOCK_RESOURCES];
+    int num_requests = 0;
+
+    if (!hint_levels_initialized) {
+        resolver_init(&hint_levels, log_hint_level);
+        hint_levels_initialized = 1;
+    }
+
+    if (resource_values)
+        num_requests = decode_resources(resource_values, num_resources,
+                requests, MAX_LOCK_RESOURCES);
+
+    resolver_set(&hint_levels, hint_id, requests, num_requests);
+    resolver_flush(&hint_levels);
+}
+
+static int acquire_hint_action(int hint_id, const int resource_values[],
+        int num_resources, int keep_on_failure)
+{
+    if (perf_lock_acq) {
+        long long start_us = hint_stats_now_us();
+        /* Acquire an indefinite lock for the requested resources. */
+        int lock_handle = perf_lock_acq(0, 0, (int *)resource_values,
+                num_resources);
+
+        perflock_stats_acquire(start_us, lock_handle == -1);
+        hint_stats_action(lock_handle == -1);
+
+        if (lock_handle == -1) {
+            int active;
+
+            ALOGE("Failed to acquire lock.");
+
+            pthread_mutex_lock(&active_hints_lock);
+            active = hint_table_contains(&active_hints, hint_id);
+            pthread_mutex_unlock(&active_hints_lock);
+
+            /* Don't leave the state being replaced in place. */
+            if (active && !keep_on_failure)
+                undo_hint_action(hint_id);
+            return -1;
+        } else {
+            unsigned long old_handle;
+            int rc;
+
+            /* Add this handle to our internal hint table. */
+            pthread_mutex_lock(&active_hints_lock);
+            rc = hint_table_insert(&active_hints, hint_id, lock_handle,
+                    &old_handle);
+            if (rc == 0)
+                update_hint_levels(hint_id, resource_values, num_resources);
+            pthread_mutex_unlock(&active_hints_lock);
+
+            if (rc == -1) {
+                /* Can't keep track of this lock. Release it. */
+                if (perf_lock_rel)
+                    perf_lock_rel(lock_handle);
+
+                ALOGE("Failed to process hint.");
+                hint_stats_action(1);
+                return -1;
+            } else if (old_handle && perf_lock_rel) {
+                /* Hint was re-sent; drop the lock it replaces. */
+                perf_lock_rel(old_handle);
             }
+
+            return 0;
         }
     }
+
+    hint_stats_action(1);
+    return -1;
+}
+
+/*
+ * Holds resource_values under hint_id until undo_hint_action(). If the
+ * hint_id already holds a lock, the new lock is taken before the old one
+ * is dropped, so switching e.g. between two profiles never passes through
+ * the defaults for resources both of them raise. Returns -1 if the lock
+ * couldn't be taken.
+ */
+int perform_hint_action(int hint_id, const int resource_values[],
+        int num_resources)
+{
+    return acquire_hint_action(hint_id, resource_values, num_resources, 0);
+}
+
+/*
+ * Like perform_hint_action(), but if the new lock can't be taken the
+ * hint_id keeps the lock it already holds.
+ */
+int replace_hint_action(int hint_id, const int resource_values[],
+        int num_resources)
+{
+    return acquire_hint_action(hint_id, resource_values, num_resources, 1);
 }
 
 void undo_hint_action(int hint_id)
 {
-    if (qcopt_handle) {
-        if (perf_lock_rel) {
-            /* Get hint-data associated with this hint-id */
-            struct list_node *found_node;
-            struct hint_data temp_hint_data = {
-                .hint_id = hint_id
-            };
-
-            found_node = find_node(&active_hint_list_head,
-                    &temp_hint_data);
-
-            if (found_node) {
-                /* Release this lock. */
-                struct hint_data *found_hint_data =
-                    (struct hint_data *)(found_node->data);
-
-                if (found_hint_data) {
-                    if (perf_lock_rel(found_hint_data->perflock_handle) == -1)
-                        ALOGE("Perflock release failed.");
-                }
-
-                if (found_node->data) {
-                    /* We can free the hint-data for this node. */
-                    free(found_node->data);
-                }
-
-                remove_list_node(&active_hint_list_head, found_node);
+    if (perf_lock_rel) {
+        unsigned long lock_handle;
+        int rc;
+
+        /* Get the perflock associated with this hint-id */
+        pthread_mutex_lock(&active_hints_lock);
+        rc = hint_table_remove(&active_hints, hint_id, &lock_handle);
+        if (rc == 0)
+            update_hint_levels(hint_id, NULL, 0);
+        pthread_mutex_unlock(&active_hints_lock);
+
+        if (rc == 0) {
+            /* Release this lock. */
+            if (perf_lock_rel(lock_handle) == -1) {
+                ALOGE("Perflock release failed.");
+                hint_stats_action(1);
             } else {
-                ALOGE("Invalid hint ID.");
+                hint_stats_action(0);
             }
+        } else {
+            ALOGE("Invalid hint ID.");
         }
     }
 }
@@ -366,24 +1402,20 @@ void undo_hint_action(int hint_id)
  */
 void undo_initial_hint_action()
 {
-    if (qcopt_handle) {
-        if (perf_lock_rel) {
-            perf_lock_rel(1);
-        }
+    if (perf_lock_rel) {
+        perf_lock_rel(1);
     }
 }
 
 /* Set a static profile */
 void set_profile(int profile)
 {
-    if (qcopt_handle) {
-        if (perf_lock_use_profile) {
-            profile_handle = perf_lock_use_profile(profile_handle, profile);
-            if (profile_handle == -1)
-                ALOGE("Failed to set profile.");
-            if (profile < 0)
-                profile_handle = 0;
-        }
+    if (perf_lock_use_profile) {
+        profile_handle = perf_lock_use_profile(profile_handle, profile);
+        if (profile_handle == -1)
+            ALOGE("Failed to set profile.");
+        if (profile < 0)
+            profile_handle = 0;
     }
 }
 
@@ -402,25 +1434,3 @@ long long calc_timespan_us(struct timespec start, struct timespec end)
     diff_in_us += (end.tv_nsec - start.tv_nsec) / NSINUS;
     return diff_in_us;
 }
-
-int get_soc_id(void)
-{
-    int fd;
-    int soc_id = -1;
-    char buf[10] = { 0 };
-
-    if (!access(SOC_ID_0, F_OK))
-        fd = open(SOC_ID_0, O_RDONLY);
-    else
-        fd = open(SOC_ID_1, O_RDONLY);
-
-    if (fd >= 0) {
-        if (read(fd, buf, sizeof(buf) - 1) == -1)
-            ALOGW("Unable to read soc_id");
-        else
-            soc_id = atoi(buf);
-    }
-
-    close(fd);
-    return soc_id;
-}
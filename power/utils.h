@@ -29,16 +29,43 @@
 
 #include <cutils/properties.h>
 
+struct perflock_backend {
+    int (*acq)(unsigned long handle, int duration, int list[], int num_args);
+    int (*rel)(unsigned long handle);
+    int (*use_profile)(unsigned long handle, int profile);
+};
+
+struct sysfs_op {
+    const char *path;
+    char *buf;      /* Value to write, or buffer to read into. */
+    int size;       /* Size of buf for a read, 0 for a write. */
+    int result;     /* 0 or -errno once the batch ran. */
+};
+
+void set_sysfs_root(const char *root);
+void set_perflock_backend(const struct perflock_backend *backend);
+
 int sysfs_read(char *path, char *s, int num_bytes);
+int sysfs_read_once(const char *path, char *s, int num_bytes);
 int sysfs_write(char *path, char *s);
+int sysfs_batch(struct sysfs_op ops[], int count);
 int get_scaling_governor(char governor[], int size);
+int get_scaling_governor_type(void);
 int get_scaling_governor_check_cores(char governor[], int size,int core_num);
+int get_cluster_scaling_governor(int cluster, char governor[], int size);
+int cluster_sysfs_read(int cluster, const char *node, char *s, int num_bytes);
+int cluster_sysfs_write(int cluster, const char *node, char *s);
 
 void vote_ondemand_io_busy_off();
 void unvote_ondemand_io_busy_off();
 void vote_ondemand_sdf_low();
 void unvote_ondemand_sdf_low();
-void perform_hint_action(int hint_id, int resource_values[],
+int adjust_interaction_duration(int duration);
+void interaction(int duration, int num_args, const int opt_list[]);
+void release_interaction_locks(void);
+int perform_hint_action(int hint_id, const int resource_values[],
+    int num_resources);
+int replace_hint_action(int hint_id, const int resource_values[],
     int num_resources);
 void undo_hint_action(int hint_id);
 void undo_initial_hint_action();
@@ -0,0 +1,329 @@
+/*
+ * Copyright (C) 2017 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * Video encode/decode, camera preview and low-latency audio hints.
+ *
+ * Every start of a hint_id takes a reference and every stop drops one.
+ * The resources are acquired when the first session of a hint_id starts
+ * and released when the last one stops, so a stop from one encoder
+ * doesn't release the boost another one still relies on, and repeated
+ * starts don't stack up perflocks.
+ */
+
+#define LOG_NIDEBUG 0
+
+#include <pthread.h>
+#include <string.h>
+
+#define LOG_TAG "QCOM PowerHAL"
+#include <utils/Log.h>
+
+#include "utils.h"
+#include "metadata-defs.h"
+#include "hint-data.h"
+#include "power-common.h"
+#include "video-hint.h"
+
+#define VIDEO_HINT_MAX_SESSIONS 8
+
+/*
+ * A hint_id with at least one running session. Free slots have no refs.
+ * pixel_rate is the largest stream started under the hint_id so far.
+ */
+struct video_session {
+    int hint_id;
+    int refs;
+    long long pixel_rate;
+    const struct resource_list *resources;
+};
+
+static struct video_session video_sessions[VIDEO_HINT_MAX_SESSIONS];
+static pthread_mutex_t video_sessions_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Fills params from video hint metadata, with the default hint_id for the
+ * hint if none is given. Returns -1 if the metadata can't be parsed.
+ */
+int parse_video_hint(power_hint_t hint, const char *metadata,
+        struct video_hint_params *params)
+{
+    if (!metadata)
+        return -1;
+
+    if (hint == POWER_HINT_VIDEO_ENCODE) {
+        struct video_encode_metadata_t video_encode_metadata = {
+            .hint_id = DEFAULT_VIDEO_ENCODE_HINT_ID,
+            .state = -1,
+        };
+
+        if (parse_video_encode_metadata(metadata, &video_encode_metadata) == -1)
+            return -1;
+
+        params->hint_id = video_encode_metadata.hint_id;
+        params->state = video_encode_metadata.state;
+        params->width = video_encode_metadata.width;
+        params->height = video_encode_metadata.height;
+        params->fps = video_encode_metadata.fps;
+        params->codec = video_encode_metadata.codec;
+    } else if (hint == POWER_HINT_VIDEO_DECODE) {
+        struct video_decode_metadata_t video_decode_metadata = {
+            .hint_id = DEFAULT_VIDEO_DECODE_HINT_ID,
+            .state = -1,
+        };
+
+        if (parse_video_decode_metadata(metadata, &video_decode_metadata) == -1)
+            return -1;
+
+        params->hint_id = video_decode_metadata.hint_id;
+        params->state = video_decode_metadata.state;
+        params->width = video_decode_metadata.width;
+        params->height = video_decode_metadata.height;
+        params->fps = video_decode_metadata.fps;
+        params->codec = video_decode_metadata.codec;
+    } else {
+        return -1;
+    }
+
+    return 0;
+}
+
+static long long video_pixel_rate(const struct video_hint_params *params)
+{
+    if (params->width <= 0 || params->height <= 0 || params->fps <= 0)
+        return DEFAULT_VIDEO_PIXEL_RATE;
+
+    return PIXEL_RATE(params->width, params->height, params->fps);
+}
+
+static struct video_session *find_video_session(int hint_id)
+{
+    int i;
+
+    for (i = 0; i < VIDEO_HINT_MAX_SESSIONS; i++) {
+        if (video_sessions[i].refs && video_sessions[i].hint_id == hint_id)
+            return &video_sessions[i];
+    }
+
+    return NULL;
+}
+
+static struct video_session *free_video_session(void)
+{
+    int i;
+
+    for (i = 0; i < VIDEO_HINT_MAX_SESSIONS; i++) {
+        if (!video_sessions[i].refs)
+            return &video_sessions[i];
+    }
+
+    return NULL;
+}
+
+/*
+ * Returns the first entry in table for the hint and the current governor
+ * that covers pixel_rate. Tables list the tiers of a hint in increasing
+ * order of max_pixel_rate.
+ */
+static const struct resource_list *find_video_resources(power_hint_t hint,
+        long long pixel_rate, const struct video_hint_resources table[],
+        int count)
+{
+    int governor, i;
+
+    if ((governor = get_scaling_governor_type()) == GOVERNOR_UNKNOWN) {
+        ALOGE("Can't obtain scaling governor.");
+        return NULL;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (table[i].hint != hint || table[i].governor != governor)
+            continue;
+
+        if (!table[i].max_pixel_rate || pixel_rate <= table[i].max_pixel_rate)
+            return &table[i].resources;
+    }
+
+    return NULL;
+}
+
+/*
+ * Starts or stops one session of a video hint, taking the resources from
+ * the entry in table matching the hint, the current governor and the
+ * stream's pixel rate. A session larger than any before it under the same
+ * hint_id moves the hint_id to the larger tier; it only drops back once
+ * every session has stopped. Returns HINT_NONE if the hint was left for
+ * another handler: no entry for the governor on a start, or a stop of a
+ * hint_id this engine doesn't hold.
+ */
+int process_video_hint(power_hint_t hint, const char *metadata,
+        const struct video_hint_resources table[], int count)
+{
+    const struct resource_list *resources;
+    struct video_hint_params params;
+    struct video_session *session;
+    long long pixel_rate;
+    int ret = HINT_NONE;
+
+    if (!metadata)
+        return HINT_NONE;
+
+    if (parse_video_hint(hint, metadata, &params) == -1) {
+        ALOGE("Error occurred while parsing metadata.");
+        return HINT_NONE;
+    }
+
+    pixel_rate = video_pixel_rate(&params);
+
+    pthread_mutex_lock(&video_sessions_lock);
+
+    session = find_video_session(params.hint_id);
+
+    if (params.state == 1) {
+        if (session) {
+            session->refs++;
+
+            if (pixel_rate > session->pixel_rate) {
+                resources = find_video_resources(hint, pixel_rate, table,
+                        count);
+                /* On failure the smaller tier's lock stays in place. */
+                if (resources == session->resources) {
+                    session->pixel_rate = pixel_rate;
+                } else if (resources && replace_hint_action(params.hint_id,
+                        resources->values, resources->count) == 0) {
+                    session->resources = resources;
+                    session->pixel_rate = pixel_rate;
+                }
+            }
+            ret = HINT_HANDLED;
+        } else if ((resources = find_video_resources(hint, pixel_rate, table,
+                count))) {
+            session = free_video_session();
+            if (!session) {
+                ALOGE("Too many video hint sessions.");
+            } else if (perform_hint_action(params.hint_id, resources->values,
+                    resources->count) == 0) {
+                session->hint_id = params.hint_id;
+                session->refs = 1;
+                session->pixel_rate = pixel_rate;
+                session->resources = resources;
+            }
+            ret = HINT_HANDLED;
+        }
+    } else if (params.state == 0) {
+        if (session) {
+            if (--session->refs == 0)
+                undo_hint_action(params.hint_id);
+            ret = HINT_HANDLED;
+        }
+    }
+
+    if (session && ret == HINT_HANDLED)
+        ALOGD("Video hint %#x: %d session(s), %lld pixels/s (codec %d)",
+                params.hint_id, session->refs, session->pixel_rate,
+                params.codec);
+
+    pthread_mutex_unlock(&video_sessions_lock);
+
+    return ret;
+}
+
+/*
+ * Takes (state 1) or drops (state 0) one reference on a mode held under
+ * hint_id, whose resources don't depend on the session.
+ */
+static void update_mode_session(const char *name, int hint_id, int state,
+        const struct resource_list *resources)
+{
+    struct video_session *session;
+
+    pthread_mutex_lock(&video_sessions_lock);
+
+    session = find_video_session(hint_id);
+
+    if (state == 1) {
+        if (session) {
+            session->refs++;
+        } else if (!(session = free_video_session())) {
+            ALOGE("Too many video hint sessions.");
+        } else if (perform_hint_action(hint_id, resources->values,
+                resources->count) == 0) {
+            session->hint_id = hint_id;
+            session->refs = 1;
+            session->pixel_rate = 0;
+            session->resources = resources;
+        }
+    } else if (state == 0 && session) {
+        if (--session->refs == 0)
+            undo_hint_action(hint_id);
+    }
+
+    if (session)
+        ALOGD("%s: %d session(s)", name, session->refs);
+
+    pthread_mutex_unlock(&video_sessions_lock);
+}
+
+/*
+ * Camera preview arrives as a video encode hint carrying
+ * CAM_PREVIEW_HINT_ID. Holds resources while at least one camera session
+ * is previewing. Returns HINT_NONE if the metadata isn't a camera preview
+ * or the SoC has no list for it, so the SoC's own handling still runs.
+ */
+int process_cam_preview_hint(const char *metadata,
+        const struct resource_list *resources)
+{
+    struct cam_preview_metadata_t cam_preview_metadata = {
+        .hint_id = -1,
+        .state = -1,
+    };
+
+    if (!metadata || !resources ||
+            parse_cam_preview_metadata(metadata, &cam_preview_metadata) == -1 ||
+            cam_preview_metadata.hint_id != CAM_PREVIEW_HINT_ID)
+        return HINT_NONE;
+
+    update_mode_session("Camera preview", CAM_PREVIEW_HINT_ID,
+            cam_preview_metadata.state, resources);
+
+    return HINT_HANDLED;
+}
+
+/*
+ * Low-latency audio arrives as a video encode (record) or decode
+ * (playback) hint carrying DEFAULT_AUDIO_HINT_ID. Holds resources while at
+ * least one audio stream is active. Returns HINT_NONE if the metadata
+ * isn't an audio hint or the SoC has no list for it.
+ */
+int process_audio_hint(const char *metadata,
+        const struct resource_list *resources)
+{
+    struct audio_metadata_t audio_metadata = {
+        .hint_id = -1,
+        .state = -1,
+    };
+
+    if (!metadata || !resources ||
+            parse_audio_metadata(metadata, &audio_metadata) == -1 ||
+            audio_metadata.hint_id != DEFAULT_AUDIO_HINT_ID)
+        return HINT_NONE;
+
+    update_mode_session("Low-latency audio", DEFAULT_AUDIO_HINT_ID,
+            audio_metadata.state, resources);
+
+    return HINT_HANDLED;
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2017 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _QCOM_VIDEO_HINT_H
+#define _QCOM_VIDEO_HINT_H
+
+#include <hardware/power.h>
+
+#include "boost-config.h"
+
+#define PIXEL_RATE(width, height, fps) \
+    ((long long)(width) * (height) * (fps))
+
+/*
+ * Sessions that don't describe their stream are sized as 1080p30, the
+ * workload the unscaled lists were tuned for.
+ */
+#define DEFAULT_VIDEO_PIXEL_RATE PIXEL_RATE(1920, 1080, 30)
+
+/*
+ * Resources held for a video hint while the given governor is in use, for
+ * streams of up to max_pixel_rate pixels per second (0: no limit).
+ */
+struct video_hint_resources {
+    power_hint_t hint;
+    int governor;
+    long long max_pixel_rate;
+    struct resource_list resources;
+};
+
+#define VIDEO_HINT_RESOURCES(hint, governor, array) \
+    { (hint), (governor), 0, RESOURCE_LIST(array) }
+#define VIDEO_HINT_SCALED(hint, governor, max_pixel_rate, array) \
+    { (hint), (governor), (max_pixel_rate), RESOURCE_LIST(array) }
+
+struct video_hint_params {
+    int hint_id;
+    int state;
+    int width;
+    int height;
+    int fps;
+    int codec;
+};
+
+int parse_video_hint(power_hint_t hint, const char *metadata,
+        struct video_hint_params *params);
+int process_video_hint(power_hint_t hint, const char *metadata,
+        const struct video_hint_resources table[], int count);
+
+/* Per-SoC camera preview and audio lists; NULL if the SoC has none. */
+const struct resource_list *get_cam_preview_resources(void);
+const struct resource_list *get_audio_resources(void);
+int process_cam_preview_hint(const char *metadata,
+        const struct resource_list *resources);
+int process_audio_hint(const char *metadata,
+        const struct resource_list *resources);
+
+#endif